@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <math.h>
+#include "../include/core/integrator.h"
+#include "../include/constant.h"
+
+/*
+ * Force evaluations against relative energy error for every integrator on an eccentric two-body orbit.
+ * Fixed step methods are swept over steps per orbit, Dormand-Prince over its relative tolerance.
+ */
+
+#define ORBITS 20
+#define ECCENTRICITY 0.6
+
+static const double sun_mass = 1.989e30;
+static const double planet_mass = 5.972e24;
+static const double semi_major_axis = 1.496e11;
+
+static void setup(Entity bodies[2]) {
+    double mu = G * (sun_mass + planet_mass);
+    double r = semi_major_axis * (1.0 + ECCENTRICITY);            // start at aphelion
+    double v = sqrt(mu * (2.0 / r - 1.0 / semi_major_axis));
+    double share = planet_mass / (sun_mass + planet_mass);
+
+    Vector zero = {0.0, 0.0, 0.0};
+    Vector sun_pos = {-share * r, 0.0, 0.0};
+    Vector sun_vel = {0.0, -share * v, 0.0};
+    Vector planet_pos = {(1.0 - share) * r, 0.0, 0.0};
+    Vector planet_vel = {0.0, (1.0 - share) * v, 0.0};
+    bodies[0] = new_entity("sun", sun_mass, 0.0, &sun_pos, &sun_vel, &zero, 1.0, false, false);
+    bodies[1] = new_entity("planet", planet_mass, 0.0, &planet_pos, &planet_vel, &zero, 1.0, false, false);
+}
+
+static double period(void) {
+    return 2.0 * PI * sqrt(pow(semi_major_axis, 3.0) / (G * (sun_mass + planet_mass)));
+}
+
+static void run(const char* label, IntegratorType type, int steps_per_orbit, double rel_tol) {
+    Entity bodies[2];
+    setup(bodies);
+    double e0 = gravity_system_energy(bodies, 2);
+
+    Integrator it;
+    integrator_init(&it, type, integrator_gravity_accelerations, NULL);
+    it.rel_tol = rel_tol;
+    it.abs_tol = rel_tol * 1e-3;
+
+    double dt = period() / steps_per_orbit;
+    ErrorCode rc = OPERATION_SET_SUCCESS;
+    for (int s = 0; s < ORBITS * steps_per_orbit && rc == OPERATION_SET_SUCCESS; s++) {
+        rc = integrator_step(&it, bodies, 2, dt);
+    }
+
+    double error = fabs((gravity_system_energy(bodies, 2) - e0) / e0);
+    if (type == INTEGRATOR_DORMAND_PRINCE) {
+        printf("%-16s tol %7.0e %12zu %12.3e %s\n", label, rel_tol, it.force_evaluations, error,
+               rc == OPERATION_SET_SUCCESS ? "" : "failed");
+    } else {
+        printf("%-16s %5d/orbit %12zu %12.3e %s\n", label, steps_per_orbit, it.force_evaluations, error,
+               rc == OPERATION_SET_SUCCESS ? "" : "failed");
+    }
+    integrator_free(&it);
+}
+
+int main(void) {
+    static const struct {
+        const char* label;
+        IntegratorType type;
+    } fixed[] = {
+        {"euler", INTEGRATOR_EULER},
+        {"velocity-verlet", INTEGRATOR_VELOCITY_VERLET},
+        {"yoshida4", INTEGRATOR_YOSHIDA4}
+    };
+
+    printf("two-body orbit, e = %.1f, %d orbits\n", ECCENTRICITY, ORBITS);
+    printf("%-16s %10s %12s %12s\n", "integrator", "setting", "evaluations", "|dE/E|");
+
+    for (size_t m = 0; m < sizeof(fixed) / sizeof(fixed[0]); m++) {
+        for (int steps = 100; steps <= 6400; steps *= 4) {
+            run(fixed[m].label, fixed[m].type, steps, 0.0);
+        }
+    }
+    // one call per orbit, the adaptive substeps do the work
+    for (double tol = 1e-4; tol >= 1e-12; tol *= 1e-2) {
+        run("dormand-prince", INTEGRATOR_DORMAND_PRINCE, 1, tol);
+    }
+    return 0;
+}
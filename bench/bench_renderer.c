@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../include/graphics/renderer.h"
+#include "../include/constant.h"
+
+/*
+ * Per-frame timings of the tiled renderer for 100k spheres at 1080p, with the camera orbiting the cloud.
+ * Pass a file prefix to also write the frames as PNG.
+ */
+
+#define SPHERES 100000
+#define FRAMES 20
+#define WIDTH 1920
+#define HEIGHT 1080
+
+int main(int argc, char** argv) {
+    const char* prefix = argc > 1 ? argv[1] : NULL;
+
+    Sphere* spheres = malloc(SPHERES * sizeof(Sphere));
+    if (!spheres) return 1;
+
+    srand(5);
+    for (int i = 0; i < SPHERES; i++) {
+        Vector p = {rand() / (double)RAND_MAX * 200.0 - 100.0,
+                    rand() / (double)RAND_MAX * 200.0 - 100.0,
+                    rand() / (double)RAND_MAX * 200.0 - 100.0};
+        spheres[i].ent = new_entity(NULL, 1.0, 0.0, &p, NULL, NULL, 1.0, true, false);
+        spheres[i].radius = 0.3 + rand() / (double)RAND_MAX * 0.7;
+    }
+
+    Renderer r;
+    if (renderer_init(&r, WIDTH, HEIGHT, 32) != OPERATION_SET_SUCCESS) {
+        free(spheres);
+        return 1;
+    }
+
+    RenderScene scene = {spheres, SPHERES, NULL, 0, NULL, 0};
+    Vector target = {0.0, 0.0, 0.0};
+    Vector up = {0.0, 1.0, 0.0};
+    RenderStats sum = {0};
+
+    printf("%d spheres, %dx%d, tile %d\n", SPHERES, WIDTH, HEIGHT, r.tile_size);
+    printf("%6s %10s %10s %10s %10s %10s %10s\n", "frame", "setup", "binning", "raster", "total", "visible", "tile refs");
+    for (int f = 0; f < FRAMES; f++) {
+        double angle = 2.0 * PI * f / FRAMES;
+        Vector eye = {250.0 * sin(angle), 60.0, 250.0 * cos(angle)};
+        Camera cam = new_camera(&eye, &target, &up, 1.0);
+
+        renderer_draw(&r, &cam, &scene, true);
+        if (prefix) framebuffer_write_frame(&r.fb, prefix, f, FRAME_FORMAT_PNG);
+
+        printf("%6d %10.2f %10.2f %10.2f %10.2f %10zu %10zu\n", f, r.stats.setup_ms, r.stats.binning_ms,
+               r.stats.raster_ms, r.stats.frame_ms, r.stats.visible_bodies, r.stats.tile_refs);
+        sum.setup_ms += r.stats.setup_ms;
+        sum.binning_ms += r.stats.binning_ms;
+        sum.raster_ms += r.stats.raster_ms;
+        sum.frame_ms += r.stats.frame_ms;
+    }
+
+    printf("%6s %10.2f %10.2f %10.2f %10.2f   ms per frame, %d threads, %.1f fps\n", "mean",
+           sum.setup_ms / FRAMES, sum.binning_ms / FRAMES, sum.raster_ms / FRAMES, sum.frame_ms / FRAMES,
+           r.stats.threads, 1000.0 * FRAMES / sum.frame_ms);
+
+    renderer_free(&r);
+    free(spheres);
+    return 0;
+}
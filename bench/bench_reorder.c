@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../include/core/reorder.h"
+#include "../include/core/field_map.h"
+#include "../include/core/potential.h"
+#include "../include/core/time_flow.h"
+
+/*
+ * Milliseconds per call of the loops that walk entity storage, first in random order and then after a Morton
+ * reorder of the same bodies, followed by the timings of the reorder itself.
+ */
+
+#define BODIES 1000000
+#define REPEATS 3
+#define GRID 160
+#define BOX 1.0
+
+typedef struct {
+    double trilinear;
+    double tricubic;
+    double potential_first;     // includes the neighbour list build
+    double potential;
+} StageTimes;
+
+static double time_field(const FieldMap* map, Entity* entities, FieldSampleMode mode) {
+    double t0 = wall_clock_ms();
+    for (int k = 0; k < REPEATS; k++) field_map_apply(map, entities, BODIES, mode);
+    return (wall_clock_ms() - t0) / REPEATS;
+}
+
+static StageTimes time_stages(const FieldMap* map, PotentialForce* force, Entity* entities) {
+    StageTimes t;
+    t.trilinear = time_field(map, entities, FIELD_SAMPLE_TRILINEAR);
+    t.tricubic = time_field(map, entities, FIELD_SAMPLE_TRICUBIC);
+
+    double t0 = wall_clock_ms();
+    potential_apply(force, entities, BODIES);
+    t.potential_first = wall_clock_ms() - t0;
+    t0 = wall_clock_ms();
+    for (int k = 0; k < REPEATS; k++) potential_apply(force, entities, BODIES);
+    t.potential = (wall_clock_ms() - t0) / REPEATS;
+    return t;
+}
+
+int main(void) {
+    Entity* entities = malloc(BODIES * sizeof(Entity));
+    double* charges = malloc(BODIES * sizeof(double));
+    if (!entities || !charges) return 1;
+
+    srand(7);
+    for (size_t i = 0; i < BODIES; i++) {
+        Vector p = {rand() / (double)RAND_MAX * BOX, rand() / (double)RAND_MAX * BOX,
+                    rand() / (double)RAND_MAX * BOX};
+        entities[i] = new_entity(NULL, 1.0, 0.0, &p, NULL, NULL, 1.0, false, false);
+        charges[i] = entities[i].charge;
+    }
+
+    FieldMap map;
+    Vector origin = {0.0, 0.0, 0.0};
+    Vector spacing = {BOX / (GRID - 1), BOX / (GRID - 1), BOX / (GRID - 1)};
+    if (field_map_create(&map, FIELD_MAP_GRAVITATIONAL, GRID, GRID, GRID, &origin, &spacing) != FIELD_SUCCESS) {
+        return 1;
+    }
+    for (size_t k = 0; k < GRID; k++) {
+        for (size_t j = 0; j < GRID; j++) {
+            for (size_t i = 0; i < GRID; i++) {
+                Vector g = {sin(0.1 * (double)i), cos(0.1 * (double)j), sin(0.1 * (double)(i + k))};
+                field_map_set(&map, i, j, k, &g);
+            }
+        }
+    }
+
+    // about 8 neighbours per body within the cutoff
+    double mean_spacing = BOX / cbrt((double)BODIES);
+    PotentialParams params;
+    potential_default_params(POTENTIAL_LENNARD_JONES, &params);
+    params.sigma = 0.5 * mean_spacing;
+    params.cutoff = 2.5 * params.sigma;
+    PotentialForce force;
+    if (potential_force_init(&force, POTENTIAL_LENNARD_JONES, &params, NULL, true, 0.3 * params.sigma)
+        != POTENTIAL_SUCCESS) {
+        return 1;
+    }
+
+    EntityReorder r;
+    if (reorder_init(&r, NULL, BODIES) != REORDER_SUCCESS) return 1;
+
+    printf("%d bodies, %d^3 field map, %d repeats\n", BODIES, GRID, REPEATS);
+    StageTimes before = time_stages(&map, &force, entities);
+    if (reorder_run(&r, entities, BODIES) != REORDER_SUCCESS) return 1;
+    double t0 = wall_clock_ms();
+    reorder_apply(&r, charges, sizeof(double));
+    double apply_ms = wall_clock_ms() - t0;
+    StageTimes after = time_stages(&map, &force, entities);
+
+    printf("%-32s %10s %10s\n", "stage (ms)", "random", "morton");
+    printf("%-32s %10.1f %10.1f\n", "field_map_apply trilinear", before.trilinear, after.trilinear);
+    printf("%-32s %10.1f %10.1f\n", "field_map_apply tricubic", before.tricubic, after.tricubic);
+    printf("%-32s %10.1f %10.1f\n", "lennard-jones, list build", before.potential_first, after.potential_first);
+    printf("%-32s %10.1f %10.1f\n", "lennard-jones, list reused", before.potential, after.potential);
+
+    ReorderStats st = reorder_stats(&r);
+    printf("reorder: locality %.2f -> %.2f, %d bits per axis, %d sort passes\n", st.locality_before,
+           st.locality_after, st.key_bits, st.sort_passes);
+    printf("%-32s %10.1f\n", "bounds", st.last_bounds_ms);
+    printf("%-32s %10.1f\n", "keys", st.last_key_ms);
+    printf("%-32s %10.1f\n", "sort", st.last_sort_ms);
+    printf("%-32s %10.1f\n", "permute", st.last_permute_ms);
+    printf("%-32s %10.1f\n", "total", st.last_total_ms);
+    printf("%-32s %10.1f\n", "reorder_apply (double)", apply_ms);
+
+    reorder_free(&r);
+    potential_force_free(&force);
+    field_map_free(&map);
+    free(charges);
+    free(entities);
+    return 0;
+}
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../include/core/movement.h"
+#include "../include/core/time_flow.h"
+#include "../include/mathlib/vec_math.h"
+#include "../include/constant.h"
+
+/*
+ * Nanoseconds per operation of the inline vec_math kernels, the out-of-line library functions (Vector.c,
+ * movement.c) and scalar copies of those functions as they were written before vec_math, which were compiled
+ * in their own translation unit and therefore are kept out of line here as well.
+ */
+
+#define BODIES 2000
+#define REPEATS 500
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+static volatile double sink;
+
+BENCH_NOINLINE static void reference_gravitation(Entity* a, Entity* b) {
+    double dx = a->position.x - b->position.x, dy = a->position.y - b->position.y, dz = a->position.z - b->position.z;
+    double distance = sqrt(dx * dx + dy * dy + dz * dz);
+    double force = -(G * a->mass * b->mass) / pow(distance, 2);
+    double fx = force * (dx / distance), fy = force * (dy / distance), fz = force * (dz / distance);
+    if (!a->is_static) {
+        a->acceleration.x += fx / a->mass;
+        a->acceleration.y += fy / a->mass;
+        a->acceleration.z += fz / a->mass;
+    }
+    if (!b->is_static) {
+        b->acceleration.x -= fx / b->mass;
+        b->acceleration.y -= fy / b->mass;
+        b->acceleration.z -= fz / b->mass;
+    }
+}
+
+BENCH_NOINLINE static void reference_quaternion_multiply(const double q1[4], const double q2[4], double r[4]) {
+    r[0] = q1[0]*q2[0] - q1[1]*q2[1] - q1[2]*q2[2] - q1[3]*q2[3];
+    r[1] = q1[0]*q2[1] + q1[1]*q2[0] + q1[2]*q2[3] - q1[3]*q2[2];
+    r[2] = q1[0]*q2[2] - q1[1]*q2[3] + q1[2]*q2[0] + q1[3]*q2[1];
+    r[3] = q1[0]*q2[3] + q1[1]*q2[2] - q1[2]*q2[1] + q1[3]*q2[0];
+}
+
+BENCH_NOINLINE static void reference_quaternion_normalize(double q[4]) {
+    double length = sqrt(q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3]);
+    if (length > 1e-10) {
+        q[0] /= length;
+        q[1] /= length;
+        q[2] /= length;
+        q[3] /= length;
+    }
+}
+
+BENCH_NOINLINE static void reference_rotate_vector(const Vector* v, const double q[4], Vector* result) {
+    double vq[4] = {0.0, v->x, v->y, v->z};
+    double conj[4] = {q[0], -q[1], -q[2], -q[3]};
+    double temp[4];
+    reference_quaternion_multiply(q, vq, temp);
+    reference_quaternion_multiply(temp, conj, vq);
+    result->x = vq[1];
+    result->y = vq[2];
+    result->z = vq[3];
+}
+
+BENCH_NOINLINE static void reference_integrate(double q[4], const Vector* omega, double dt) {
+    double omega_q[4] = {0.0, omega->x, omega->y, omega->z};
+    double dq[4];
+    reference_quaternion_multiply(omega_q, q, dq);
+    for (int k = 0; k < 4; k++) q[k] += 0.5 * dq[k] * dt;
+    reference_quaternion_normalize(q);
+}
+
+typedef enum { VARIANT_REFERENCE, VARIANT_LIBRARY, VARIANT_INLINE, VARIANT_COUNT } Variant;
+
+static Entity bodies[BODIES];
+static Vector vectors[BODIES];
+
+static double gravity_ns(Variant v) {
+    if (v == VARIANT_INLINE) return NAN;     // apply_universal_gravitation is the vec_math kernel
+    double t0 = wall_clock_ms();
+    for (int i = 0; i < BODIES; i++) {
+        for (int j = i + 1; j < BODIES; j++) {
+            if (v == VARIANT_REFERENCE) reference_gravitation(&bodies[i], &bodies[j]);
+            else apply_universal_gravitation(&bodies[i], &bodies[j]);
+        }
+    }
+    sink = bodies[0].acceleration.x;
+    return (wall_clock_ms() - t0) * 1e6 / (BODIES * (BODIES - 1) / 2.0);
+}
+
+static double dot_ns(Variant v) {
+    if (v == VARIANT_REFERENCE) return NAN;
+    double acc = 0.0;
+    double t0 = wall_clock_ms();
+    for (int r = 0; r < REPEATS; r++) {
+        for (int i = 1; i < BODIES; i++) {
+            acc += v == VARIANT_LIBRARY ? dot_product(vectors[i - 1], vectors[i]) : vec3_dot(vectors[i - 1], vectors[i]);
+        }
+    }
+    sink = acc;
+    return (wall_clock_ms() - t0) * 1e6 / ((double)REPEATS * (BODIES - 1));
+}
+
+static double cross_ns(Variant v) {
+    if (v == VARIANT_REFERENCE) return NAN;
+    Vector acc = {0.0, 0.0, 0.0};
+    double t0 = wall_clock_ms();
+    for (int r = 0; r < REPEATS; r++) {
+        for (int i = 1; i < BODIES; i++) {
+            Vector c = v == VARIANT_LIBRARY ? cross_product(vectors[i - 1], vectors[i])
+                                            : vec3_cross(vectors[i - 1], vectors[i]);
+            acc = vec3_add(acc, c);
+        }
+    }
+    sink = acc.x + acc.y + acc.z;
+    return (wall_clock_ms() - t0) * 1e6 / ((double)REPEATS * (BODIES - 1));
+}
+
+static double quat_mul_ns(Variant v) {
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    double t0 = wall_clock_ms();
+    for (int r = 0; r < REPEATS; r++) {
+        for (int i = 1; i < BODIES; i++) {
+            double out[4];
+            const double* a = bodies[i - 1].quaternion;
+            const double* b = bodies[i].quaternion;
+            if (v == VARIANT_REFERENCE) reference_quaternion_multiply(a, b, out);
+            else if (v == VARIANT_LIBRARY) quaternion_multiply(a, b, out);
+            else quat_mul(a, b, out);
+            vec4_axpy(acc, 1.0, out);
+        }
+    }
+    sink = acc[0] + acc[1] + acc[2] + acc[3];
+    return (wall_clock_ms() - t0) * 1e6 / ((double)REPEATS * (BODIES - 1));
+}
+
+static double rotate_ns(Variant v) {
+    Vector acc = {0.0, 0.0, 0.0};
+    double t0 = wall_clock_ms();
+    for (int r = 0; r < REPEATS; r++) {
+        for (int i = 0; i < BODIES; i++) {
+            Vector out;
+            if (v == VARIANT_REFERENCE) reference_rotate_vector(&vectors[i], bodies[i].quaternion, &out);
+            else if (v == VARIANT_LIBRARY) rotate_vector_by_quaternion(&vectors[i], bodies[i].quaternion, &out);
+            else out = quat_rotate(bodies[i].quaternion, vectors[i]);
+            acc = vec3_add(acc, out);
+        }
+    }
+    sink = acc.x + acc.y + acc.z;
+    return (wall_clock_ms() - t0) * 1e6 / ((double)REPEATS * BODIES);
+}
+
+static double integrate_ns(Variant v) {
+    double t0 = wall_clock_ms();
+    for (int r = 0; r < REPEATS; r++) {
+        for (int i = 0; i < BODIES; i++) {
+            double* q = bodies[i].quaternion;
+            if (v == VARIANT_REFERENCE) reference_integrate(q, &bodies[i].angular_velocity, 1e-3);
+            else if (v == VARIANT_LIBRARY) update_quaternion_with_angular_velocity(q, &bodies[i].angular_velocity, 1e-3);
+            else quat_integrate(q, bodies[i].angular_velocity, 1e-3);
+        }
+    }
+    sink = bodies[0].quaternion[0];
+    return (wall_clock_ms() - t0) * 1e6 / ((double)REPEATS * BODIES);
+}
+
+int main(void) {
+    static const struct {
+        const char* name;
+        double (*run)(Variant v);
+    } ops[] = {
+        {"vec3 dot", dot_ns},
+        {"vec3 cross", cross_ns},
+        {"gravity pair", gravity_ns},
+        {"quaternion multiply", quat_mul_ns},
+        {"rotate vector", rotate_ns},
+        {"integrate quaternion", integrate_ns}
+    };
+
+    srand(3);
+    for (int i = 0; i < BODIES; i++) {
+        Vector p = {rand() % 1000, rand() % 1000, rand() % 1000};
+        bodies[i] = new_entity(NULL, 1.0 + i, 0.0, &p, NULL, NULL, 1.0, true, false);
+        bodies[i].angular_velocity = vec3(0.1, 0.2, 0.3);
+        quat_from_axis_angle(vec3(rand() % 7 + 1, rand() % 5, rand() % 3), 0.001 * i, bodies[i].quaternion);
+        vectors[i] = vec3(rand() / (double)RAND_MAX, rand() / (double)RAND_MAX, rand() / (double)RAND_MAX);
+    }
+
+    printf("%-22s %12s %12s %12s   (ns per operation)\n", "operation", "reference", "library", "inline");
+    for (size_t k = 0; k < sizeof(ops) / sizeof(ops[0]); k++) {
+        double ns[VARIANT_COUNT];
+        for (int v = 0; v < VARIANT_COUNT; v++) {
+            ops[k].run((Variant)v);     // warm up
+            ns[v] = ops[k].run((Variant)v);
+        }
+        printf("%-22s", ops[k].name);
+        for (int v = 0; v < VARIANT_COUNT; v++) {
+            if (isnan(ns[v])) printf(" %12s", "-");
+            else printf(" %12.2f", ns[v]);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -7,12 +7,18 @@ extern "C" {
 #endif
 
 #include "../core/entity.h"
+#include "../core/shape.h"
 typedef struct Cube {
     Entity ent;
     double height;
     double width;
 }Cube;
 
+/**
+ * @brief Narrow phase shape of c, pass it with &c->ent to narrowphase_add or narrowphase_collide
+ */
+SceneShape cube_shape(const Cube* c);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include "../core/entity.h"
+#include "../core/shape.h"
 typedef struct Cylinder {
     Entity ent;
     double height;
@@ -14,6 +15,11 @@ typedef struct Cylinder {
 
 Cylinder* new_cylinder(Entity e, double h, double r);
 
+/**
+ * @brief Narrow phase shape of c, pass it with &c->ent to narrowphase_add or narrowphase_collide
+ */
+SceneShape cylinder_shape(const Cylinder* c);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,14 +6,26 @@ extern "C" {
 #endif
 
 #include "../core/entity.h"
+#include "../core/shape.h"
 typedef struct Sphere {
     Entity ent;
     double radius;
 }Sphere;
 
+struct Renderer;
+struct Camera;
+
 Sphere* new_sphere(const Entity e, const double r);
 
-ErrorCode sphere_draw_basic(Sphere s);
+/**
+ * @brief Narrow phase shape of s, pass it with &s->ent to narrowphase_add or narrowphase_collide
+ */
+SceneShape sphere_shape(const Sphere* s);
+
+/**
+ * @brief Draw one sphere into r as seen from cam, without clearing the framebuffer
+ */
+ErrorCode sphere_draw_basic(Sphere s, struct Renderer* r, const struct Camera* cam);
 
 #ifdef __cplusplus
 }
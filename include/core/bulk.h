@@ -0,0 +1,86 @@
+#ifndef CPHYSICS_BULK_H
+#define CPHYSICS_BULK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "entity.h"
+
+/**
+ * @brief Per entity columns exposed to the bulk API, each is a run of doubles inside Entity
+ */
+typedef enum {
+    ENTITY_COLUMN_POSITION,         // 3 doubles
+    ENTITY_COLUMN_VELOCITY,         // 3 doubles
+    ENTITY_COLUMN_ACCELERATION,     // 3 doubles
+    ENTITY_COLUMN_MASS,             // 1 double
+    ENTITY_COLUMN_CHARGE,           // 1 double
+    ENTITY_COLUMN_QUATERNION,       // 4 doubles (w, x, y, z)
+    ENTITY_COLUMN_ANGULAR_VELOCITY, // 3 doubles
+    ENTITY_COLUMN_COUNT
+} EntityColumn;
+
+/**
+ * @brief Strided view of one column, element (i, c) is data[i * stride + c * component_stride]
+ *
+ * Strides are in doubles and may be negative, as for reversed NumPy arrays; data points at element (0, 0).
+ * A packed (n, 3) C array has stride 3 and component_stride 1.
+ */
+typedef struct ColumnView {
+    double* data;
+    size_t count;
+    size_t components;
+    ptrdiff_t stride;
+    ptrdiff_t component_stride;
+} ColumnView;
+
+/**
+ * @brief Layout of Entity for bindings that map an entity array directly (e.g. a NumPy structured dtype)
+ */
+typedef struct EntityLayout {
+    size_t size;
+    size_t alignment;
+    size_t offsets[ENTITY_COLUMN_COUNT];
+    size_t components[ENTITY_COLUMN_COUNT];
+} EntityLayout;
+
+void entity_layout(EntityLayout* layout);
+
+/**
+ * @brief Use caller owned memory as entity storage without copying
+ *
+ * The memory must already hold whole Entity structs laid out as entity_layout describes. The engine works on
+ * Entity arrays, so separate position/velocity/... arrays cannot be borrowed; copy them in and out with
+ * bulk_set_column / bulk_get_column instead.
+ *
+ * @return ENTITY_VOID_ERROR on NULL, OPERATION_GET_FAILED if memory is misaligned or holds less than count entities
+ */
+ErrorCode bulk_borrow_entities(void* memory, size_t bytes, size_t count, Entity** entities);
+
+/**
+ * @brief Zero-copy view of a column of an entity array, stride is sizeof(Entity) / sizeof(double)
+ */
+ErrorCode bulk_column_view(Entity* entities, size_t count, EntityColumn column, ColumnView* view);
+
+/**
+ * @brief Copy a column of count entities out to a strided buffer
+ */
+ErrorCode bulk_get_column(const Entity* entities, size_t count, EntityColumn column,
+                          double* out, ptrdiff_t stride, ptrdiff_t component_stride);
+
+/**
+ * @brief Copy a strided buffer into a column of count entities
+ */
+ErrorCode bulk_set_column(Entity* entities, size_t count, EntityColumn column,
+                          const double* in, ptrdiff_t stride, ptrdiff_t component_stride);
+
+ErrorCode bulk_get_view(const Entity* entities, EntityColumn column, const ColumnView* out);
+ErrorCode bulk_set_view(Entity* entities, EntityColumn column, const ColumnView* in);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_BULK_H
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include "entity.h"
+#include "narrowphase.h"
 
 /**
  * @brief Process collision between two entities
@@ -18,6 +19,30 @@ extern "C" {
  */
 void process_collision(Entity* obj_1, Entity* obj_2, double* loss);
 
+/**
+ * @brief Resolve a narrow phase contact between two entities
+ *
+ * Separates the bodies along the contact normal by the penetration depth, split by inverse mass, and applies
+ * the restitution impulse along the normal if they approach. Bodies are treated as point masses, no spin is
+ * induced. Contacts with depth <= 0 are ignored.
+ *
+ * @param contact Contact with the normal pointing from obj_1 to obj_2
+ * @param loss Energy loss pointer (optional)
+ */
+void process_contact(Entity* obj_1, Entity* obj_2, const Contact* contact, double* loss);
+
+/**
+ * @brief Restitution impulse between two touching bodies, positions are left unchanged
+ *
+ * Uses the smaller coefficient of restitution of the two. Static and massless bodies take no impulse,
+ * nothing happens unless the bodies approach along the normal.
+ *
+ * @param normal Unit normal pointing from obj_1 to obj_2
+ * @param loss Energy loss pointer (optional)
+ * @return Magnitude of the applied impulse
+ */
+double apply_restitution_impulse(Entity* obj_1, Entity* obj_2, const Vector* normal, double* loss);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,103 @@
+#ifndef CPHYSICS_DOMAIN_H
+#define CPHYSICS_DOMAIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "entity.h"
+
+/**
+ * @brief Slab decomposition of the simulation domain across local worker processes
+ *
+ * The extent [lower, upper) along axis is split into process_count equal slabs, one worker process
+ * per slab (typically one per NUMA node). Bodies outside the extent belong to the first/last slab.
+ */
+typedef struct DomainConfig {
+    int process_count;
+    int axis;               // 0 = x, 1 = y, 2 = z
+    double lower;
+    double upper;
+    double halo_width;      // bodies closer than this to a slab boundary are sent to the neighbour as ghosts
+    size_t max_local;       // capacity of the local entity storage of each worker
+    size_t ring_capacity;   // entries of each shared-memory halo and migration ring
+} DomainConfig;
+
+/**
+ * @brief Per worker counters, filled after domain_run returns
+ */
+typedef struct DomainStats {
+    size_t local_count;
+    size_t ghosts_sent;
+    size_t ghosts_dropped;      // ring full, the neighbour did not see the ghost
+    size_t migrated_out;
+    size_t migrations_deferred; // ring full, the body stays one more step in the old slab
+    double step_ms;             // wall time spent in the step callback
+    double exchange_ms;         // wall time spent exchanging and waiting at barriers
+} DomainStats;
+
+typedef enum {
+    DOMAIN_SUCCESS = 0,
+    DOMAIN_ERROR_NULL_POINTER,
+    DOMAIN_ERROR_INVALID_CONFIG,
+    DOMAIN_ERROR_CAPACITY,
+    DOMAIN_ERROR_SHARED_MEMORY,
+    DOMAIN_ERROR_PROCESS,
+    DOMAIN_ERROR_UNSUPPORTED
+} DomainErrorCode;
+
+/**
+ * @brief Advance the bodies owned by one worker by dt
+ *
+ * ghosts are read-only copies of the neighbours' boundary bodies for this step; changes to them are discarded.
+ */
+typedef void (*DomainStepFn)(Entity* local, size_t local_count, Entity* ghosts, size_t ghost_count,
+                             double dt, void* user);
+
+/**
+ * @brief Optional user data of domain_default_step
+ */
+typedef struct DomainStepParams {
+    double collision_distance;  // pairs closer than this are resolved with process_collision, 0 disables
+} DomainStepParams;
+
+/**
+ * @brief Gravitation and collisions between local bodies and with ghosts, followed by an explicit Euler step
+ *
+ * user may point to a DomainStepParams; with NULL no collisions are processed.
+ */
+void domain_default_step(Entity* local, size_t local_count, Entity* ghosts, size_t ghost_count,
+                         double dt, void* user);
+
+/**
+ * @brief Slab index owning a position
+ */
+int domain_index_of(const DomainConfig* cfg, const Vector* position);
+
+/**
+ * @brief Run steps of the simulation split across cfg->process_count forked workers
+ *
+ * Workers exchange ghost bodies and migrate bodies that left their slab through POSIX shared-memory
+ * ring buffers, synchronised with a barrier on atomics in the shared segment. On Linux worker d is pinned to the CPUs of NUMA
+ * node d mod node count (to an equal share of the allowed CPUs on single-node machines) and allocates its
+ * local storage after that, so the memory is first-touched on the node it runs on.
+ * On return entities holds the final state grouped by slab and count is updated.
+ *
+ * The step callback runs in a forked child with a single OpenMP thread: OpenMP runtimes do not support
+ * parallel regions in a child forked after the parent used OpenMP. If a worker dies the others are killed
+ * and DOMAIN_ERROR_PROCESS is returned. Only the worker pids are waited for, other children of the caller
+ * are left alone.
+ *
+ * @param entities Bodies to simulate, at least capacity entries of storage
+ * @param count In: number of bodies, out: number of bodies after the run
+ * @param stats Optional array of cfg->process_count entries
+ */
+DomainErrorCode domain_run(const DomainConfig* cfg, Entity* entities, size_t* count, size_t capacity,
+                           size_t steps, double dt, DomainStepFn step, void* user, DomainStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_DOMAIN_H
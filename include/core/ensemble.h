@@ -0,0 +1,90 @@
+#ifndef CPHYSICS_ENSEMBLE_H
+#define CPHYSICS_ENSEMBLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "entity.h"
+
+// worlds handled together by one thread, the SIMD loops run across the worlds of a block
+#define ENSEMBLE_BLOCK 64
+
+/**
+ * @brief Many small independent worlds stepped in lockstep
+ *
+ * Body arrays are indexed [slot * world_capacity + lane]: the same body slot of all worlds is contiguous so
+ * the inner loops vectorise across worlds. Per world arrays are indexed by lane. Lanes are renumbered by
+ * ensemble_compact, world_id[lane] keeps the original index of the world.
+ * Unused slots have zero mass and radius and do not interact.
+ */
+typedef struct Ensemble {
+    size_t world_count;
+    size_t world_capacity;  // multiple of ENSEMBLE_BLOCK
+    size_t slot_count;
+
+    double* px; double* py; double* pz;
+    double* vx; double* vy; double* vz;
+    double* ax; double* ay; double* az;
+    double* mass;
+    double* inv_mass;       // 0 for static bodies and unused slots
+    double* charge;
+    double* radius;
+
+    double* dt;
+    double* restitution;
+    double* gravity_constant;       // pairwise gravitation strength, defaults to G
+    double* gx; double* gy; double* gz;   // uniform gravitational field (acceleration)
+    double* ex; double* ey; double* ez;   // uniform electric field
+    double* time;
+    double* t_end;          // worlds retire once time reaches t_end, defaults to infinity
+    unsigned char* retired;
+    size_t* world_id;
+
+    double* storage;
+} Ensemble;
+
+/**
+ * @brief Called by ensemble_compact for every retired world before its lane is reused
+ */
+typedef void (*EnsembleRetireFn)(const Ensemble* ens, size_t lane, void* user);
+
+ErrorCode ensemble_init(Ensemble* ens, size_t worlds, size_t slots);
+void ensemble_free(Ensemble* ens);
+
+/**
+ * @brief Copy an entity into a body slot of the world in lane, static entities get inv_mass 0
+ */
+ErrorCode ensemble_set_body(Ensemble* ens, size_t lane, size_t slot, const Entity* e, double radius);
+ErrorCode ensemble_get_body(const Ensemble* ens, size_t lane, size_t slot, Entity* out);
+
+/**
+ * @brief Set the per world parameters of a lane, field vectors may be NULL for zero
+ */
+ErrorCode ensemble_set_world(Ensemble* ens, size_t lane, double dt, double restitution,
+                             const Vector* gravity_field, const Vector* electric_field);
+
+/**
+ * @brief Advance all live worlds by steps steps of their own dt
+ *
+ * Each step applies the uniform fields, pairwise gravitation and Coulomb forces, a semi-implicit Euler update
+ * and restitution impulses for overlapping approaching bodies (radius based, bodies of radius 0 never collide).
+ * Blocks of worlds run on separate threads when OpenMP is available. Retired worlds are frozen.
+ */
+ErrorCode ensemble_step(Ensemble* ens, size_t steps);
+
+void ensemble_retire(Ensemble* ens, size_t lane);
+
+/**
+ * @brief Move the surviving worlds to the front lanes
+ *
+ * @return The number of live worlds
+ */
+size_t ensemble_compact(Ensemble* ens, EnsembleRetireFn on_retire, void* user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_ENSEMBLE_H
@@ -11,12 +11,15 @@ extern "C" {
 #include "../constant.h"
 #include "../error_codes.h"
 #include "../mathlib/Vector.h"
+#include "name_registry.h"
 
 
 
 
+/**
+ * @brief name_id refers to the default name registry, entity_name resolves it
+ */
 typedef struct Entity {
-    char name[256];
     double mass;
     double charge;
     Vector position;
@@ -27,6 +30,7 @@ typedef struct Entity {
     Vector angular_acceleration;
     double moment_of_inertia;
     double coefficient_of_restitution;
+    NameId name_id;
     bool rigid_body;
     bool is_static;
 } Entity;
@@ -36,6 +40,16 @@ struct Entity new_entity(const char* n, double m, double c,
                                    const Vector* d, const Vector* v,
                                    const Vector* a, double cor, bool rigid, bool s);
 
+/**
+ * @brief Name of an entity, "" when it has none
+ */
+const char* entity_name(const Entity* obj);
+
+/**
+ * @brief Rename an entity, interning the name in the default registry
+ */
+ErrorCode set_entity_name(Entity* obj, const char* name);
+
 Vector* get_position(Entity* obj);
 Vector* get_acceleration(Entity* obj);
 Vector* get_velocity(Entity* obj);
@@ -28,7 +28,11 @@ typedef enum {
     FIELD_ERROR_NULL_POINTER,
     FIELD_ERROR_INVALID_MASS,
     FIELD_ERROR_INVALID_CHARGE,
-    FIELD_ERROR_STATIC_OBJECT
+    FIELD_ERROR_STATIC_OBJECT,
+    FIELD_ERROR_INVALID_MAP,
+    FIELD_ERROR_IO,
+    FIELD_ERROR_FORMAT,
+    FIELD_ERROR_OUT_OF_MEMORY
 } FieldErrorCode;
 
 FieldErrorCode apply_gravitational_field(Entity* obj, const gravitational_field* g);
@@ -0,0 +1,92 @@
+#ifndef CPHYSICS_FIELD_MAP_H
+#define CPHYSICS_FIELD_MAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "field.h"
+
+// grid points per brick edge, bricks hold FIELD_MAP_BRICK^3 points in Morton order
+#define FIELD_MAP_BRICK 4
+
+typedef enum {
+    FIELD_MAP_GRAVITATIONAL,    // values are accelerations (m/s^2)
+    FIELD_MAP_ELECTRIC,         // values are field strengths (V/m)
+    FIELD_MAP_MAGNETIC          // values are flux densities (T)
+} FieldMapKind;
+
+typedef enum {
+    FIELD_SAMPLE_TRILINEAR,     // 8 neighbouring grid points
+    FIELD_SAMPLE_TRICUBIC       // Catmull-Rom over 4x4x4 grid points, interpolates the grid values
+} FieldSampleMode;
+
+/**
+ * @brief Vector field sampled on a regular grid
+ *
+ * Grid point (i, j, k) sits at origin + (i, j, k) * spacing. Points are stored in bricks of 4x4x4 (row-major
+ * brick order, Morton order inside a brick) so the neighbours of a lookup share cache lines. Maps loaded
+ * with field_map_load are memory-mapped read only and shared with other processes mapping the same file.
+ */
+typedef struct FieldMap {
+    FieldMapKind kind;
+    size_t nx, ny, nz;          // grid points per axis
+    size_t bx, by, bz;          // bricks per axis
+    Vector origin;
+    Vector spacing;
+    Vector inv_spacing;
+    const double* data;         // 3 components per point in brick order
+
+    double* owned;              // heap storage of maps built in memory
+    void* mapping;              // file mapping of loaded maps
+    size_t mapping_size;
+} FieldMap;
+
+/**
+ * @brief Allocate a zeroed map of nx * ny * nz grid points
+ */
+FieldErrorCode field_map_create(FieldMap* map, FieldMapKind kind, size_t nx, size_t ny, size_t nz,
+                                const Vector* origin, const Vector* spacing);
+void field_map_free(FieldMap* map);
+
+/**
+ * @brief Write one grid point, only for maps built with field_map_create
+ */
+FieldErrorCode field_map_set(FieldMap* map, size_t i, size_t j, size_t k, const Vector* value);
+FieldErrorCode field_map_get(const FieldMap* map, size_t i, size_t j, size_t k, Vector* value);
+
+/**
+ * @brief Save in the binary field map format (doc/FieldMap.md)
+ */
+FieldErrorCode field_map_save(const FieldMap* map, const char* path);
+
+/**
+ * @brief Map a binary field map file read only, the data is used in place without copying
+ */
+FieldErrorCode field_map_load(FieldMap* map, const char* path);
+
+/**
+ * @brief Field value at a position, positions outside the grid take the value at the nearest boundary
+ */
+Vector field_map_sample(const FieldMap* map, const Vector* position, FieldSampleMode mode);
+
+/**
+ * @brief Field values at the positions of count entities
+ */
+FieldErrorCode field_map_sample_entities(const FieldMap* map, const Entity* entities, size_t count,
+                                         FieldSampleMode mode, Vector* out);
+
+/**
+ * @brief Add the acceleration caused by the field to every non static entity
+ *
+ * Gravitational maps add the sampled value, electric maps q/m E and magnetic maps q/m v x B. Entities
+ * without mass are skipped by electric and magnetic maps. Large batches run in parallel when OpenMP is available.
+ */
+FieldErrorCode field_map_apply(const FieldMap* map, Entity* entities, size_t count, FieldSampleMode mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_FIELD_MAP_H
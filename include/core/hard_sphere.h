@@ -0,0 +1,131 @@
+#ifndef CPHYSICS_HARD_SPHERE_H
+#define CPHYSICS_HARD_SPHERE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "entity.h"
+
+typedef struct HardSphereConfig {
+    Vector box_min;             // walls of the container, sphere centres stay within radius of them
+    Vector box_max;
+    double wall_restitution;    // the smaller of this and the sphere's coefficient is used
+    size_t max_cells;           // upper bound on grid cells, 0 for about one per sphere
+    size_t max_events;          // events per hard_sphere_advance call before giving up, 0 unbounded
+} HardSphereConfig;
+
+// default max_events, stops an inelastic collapse after seconds instead of never
+#define HARD_SPHERE_DEFAULT_MAX_EVENTS ((size_t)100000000)
+
+typedef enum {
+    HARD_SPHERE_SUCCESS = 0,
+    HARD_SPHERE_ERROR_NULL_POINTER,
+    HARD_SPHERE_ERROR_INVALID_CONFIG,
+    HARD_SPHERE_ERROR_INVALID_RADIUS,
+    HARD_SPHERE_ERROR_OUTSIDE_BOX,
+    HARD_SPHERE_ERROR_EVENT_LIMIT,
+    HARD_SPHERE_ERROR_OUT_OF_MEMORY,
+    HARD_SPHERE_ERROR_INVALID_MASS
+} HardSphereErrorCode;
+
+typedef struct HardSphereStats {
+    size_t collisions;          // sphere-sphere
+    size_t wall_collisions;
+    size_t cell_crossings;
+    size_t stale_events;        // predictions invalidated by an earlier collision of the partner
+    double energy_loss;         // kinetic energy removed by restitution
+    double run_ms;              // wall clock time spent in hard_sphere_advance
+    double collisions_per_second; // sphere-sphere collisions per wall clock second
+} HardSphereStats;
+
+/**
+ * @brief Event-driven simulation of spheres in free flight inside a box
+ *
+ * Instead of stepping time, the exact times of the next sphere-sphere collision, wall collision and grid cell
+ * crossing of every sphere are predicted and kept in an indexed priority queue. Events are processed in time
+ * order and only the spheres taking part are moved to the event time, the others keep the position they had at
+ * their own last event. Collisions use apply_restitution_impulse.
+ *
+ * Accelerations are ignored, spheres move in straight lines between events. Static spheres never move.
+ *
+ * With restitution below 1, spheres can undergo inelastic collapse: they collide infinitely often in finite time,
+ * so hard_sphere_advance only returns because of max_events. Do not set max_events to 0 unless every
+ * restitution coefficient is 1.
+ */
+typedef struct HardSphereSystem {
+    HardSphereConfig config;
+    Entity* entities;
+    size_t count;
+    double* radii;
+    double time;                // time every sphere is synchronised to after hard_sphere_advance
+
+    double* local_time;         // time at which entities[i].position is valid
+    uint32_t* collision_count;  // bumped whenever a sphere's velocity changes
+
+    // next event of every sphere
+    double* event_time;
+    uint32_t* event_partner;    // sphere, wall face or crossed cell face depending on event_type
+    uint32_t* event_partner_count;
+    unsigned char* event_type;
+
+    // earliest predicted sphere-sphere collision, kept across cell crossings
+    double* sphere_time;
+    uint32_t* sphere_partner;
+    uint32_t* sphere_partner_count;
+
+    // indexed binary min-heap of spheres ordered by event_time
+    uint32_t* heap;
+    uint32_t* heap_pos;
+
+    // uniform grid with cells at least one diameter wide, spheres are kept in per-cell linked lists
+    size_t cells[3];
+    Vector cell_size;
+    uint32_t* cell_head;
+    uint32_t* cell_next;
+    uint32_t* cell_prev;
+    uint32_t* cell_of;
+
+    Entity wall;                // static body used for wall impulses
+    HardSphereStats stats;
+} HardSphereSystem;
+
+/**
+ * @brief Unit box, elastic walls, automatic grid, at most HARD_SPHERE_DEFAULT_MAX_EVENTS events per advance
+ */
+void hard_sphere_default_config(HardSphereConfig* config);
+
+/**
+ * @brief Set up a system and predict the first events
+ *
+ * The entities are simulated in place and must outlive the system.
+ *
+ * @param radii One positive radius per entity
+ * @return HARD_SPHERE_ERROR_INVALID_MASS if a non-static entity has a mass that is not positive and finite
+ */
+HardSphereErrorCode hard_sphere_init(HardSphereSystem* sys, Entity* entities, const double* radii, size_t count,
+                                     const HardSphereConfig* config);
+void hard_sphere_free(HardSphereSystem* sys);
+
+/**
+ * @brief Process every event up to time + dt and move all spheres to that time
+ *
+ * On HARD_SPHERE_ERROR_EVENT_LIMIT (typically inelastic collapse) the system is left at the last processed
+ * event, positions are synchronised to it.
+ */
+HardSphereErrorCode hard_sphere_advance(HardSphereSystem* sys, double dt);
+
+/**
+ * @brief Re-predict every event, call after changing positions or velocities outside the system
+ */
+HardSphereErrorCode hard_sphere_invalidate(HardSphereSystem* sys);
+
+HardSphereStats hard_sphere_stats(const HardSphereSystem* sys);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_HARD_SPHERE_H
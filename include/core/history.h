@@ -0,0 +1,129 @@
+#ifndef CPHYSICS_HISTORY_H
+#define CPHYSICS_HISTORY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "entity.h"
+
+// recorded values per entity: position, velocity, quaternion, angular velocity
+#define HISTORY_VALUES 13
+
+typedef enum {
+    HISTORY_LOSSLESS,   // XOR against the previous step, restores bit-exact states
+    HISTORY_QUANTIZED   // integer deltas on a fixed grid per column, smaller but lossy between keyframes;
+                        // non-finite values and values beyond 2^62 quanta are stored exactly, 9 bytes every step
+} HistoryMode;
+
+typedef struct HistoryConfig {
+    size_t keyframe_interval;   // steps per keyframe, seeking decodes at most this many steps
+    size_t max_bytes;           // memory budget, the oldest keyframe segments are dropped beyond it, 0 unbounded
+    HistoryMode mode;
+    double position_quantum;    // quantized mode only
+    double velocity_quantum;
+    double quaternion_quantum;
+    double angular_velocity_quantum;
+} HistoryConfig;
+
+typedef enum {
+    HISTORY_SUCCESS = 0,
+    HISTORY_ERROR_NULL_POINTER,
+    HISTORY_ERROR_INVALID_CONFIG,
+    HISTORY_ERROR_COUNT_MISMATCH,
+    HISTORY_ERROR_STEP_NOT_AVAILABLE,
+    HISTORY_ERROR_OUT_OF_MEMORY
+} HistoryErrorCode;
+
+typedef struct HistoryStats {
+    size_t steps_recorded;      // since init, including dropped steps
+    size_t first_step;          // oldest step that can be restored
+    size_t last_step;
+    size_t bytes;               // keyframes + deltas currently held
+    size_t keyframe_bytes;
+    size_t delta_bytes;
+    double bytes_per_step;      // bytes / retained steps
+    size_t segments_dropped;
+    double last_record_ms;
+    double last_restore_ms;
+} HistoryStats;
+
+/**
+ * @brief One keyframe and the encoded deltas of the steps following it
+ */
+typedef struct HistorySegment {
+    size_t first_step;
+    size_t step_count;          // keyframe included
+    double* keyframe;           // entity_count * HISTORY_VALUES
+    unsigned char* deltas;
+    size_t delta_size;
+    size_t delta_capacity;
+    size_t* step_end;           // end offset in deltas of each delta step
+} HistorySegment;
+
+/**
+ * @brief Rolling history of the dynamic state of a fixed set of entities
+ *
+ * Every keyframe_interval steps a full copy is stored, the steps in between only store the values that changed.
+ * Static entities are only part of keyframes and entities whose state did not change are skipped.
+ */
+typedef struct History {
+    HistoryConfig config;
+    size_t entity_count;
+
+    HistorySegment* segments;   // oldest first
+    size_t segment_count;
+    size_t segment_capacity;
+
+    uint64_t* reference;        // encoder state after the last recorded step
+    uint64_t* decode_reference; // scratch for restores
+    double* decode_values;
+    unsigned char* scratch;     // one encoded step
+    size_t next_step;
+
+    HistoryStats stats;
+} History;
+
+/**
+ * @brief Lossless, keyframe every 64 steps, unbounded, quanta of 1e-9
+ */
+void history_default_config(HistoryConfig* config);
+
+/**
+ * @param config NULL for history_default_config
+ */
+HistoryErrorCode history_init(History* h, const HistoryConfig* config, size_t entity_count);
+void history_free(History* h);
+
+/**
+ * @brief Append the current state as the next step
+ *
+ * @param step Optional, receives the index of the recorded step
+ */
+HistoryErrorCode history_record(History* h, const Entity* entities, size_t count, size_t* step);
+
+/**
+ * @brief Write the recorded state of a step back into the entities
+ *
+ * Only position, velocity, quaternion and angular velocity are restored. Decodes at most keyframe_interval
+ * steps. Call integrator_invalidate on integrators that cache accelerations.
+ */
+HistoryErrorCode history_restore(History* h, size_t step, Entity* entities, size_t count);
+
+/**
+ * @brief Forget every step after step, the next record continues from it (rollback)
+ */
+HistoryErrorCode history_truncate(History* h, size_t step);
+
+/**
+ * @brief Current memory use and timings
+ */
+HistoryStats history_stats(const History* h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_HISTORY_H
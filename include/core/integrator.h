@@ -0,0 +1,85 @@
+#ifndef CPHYSICS_INTEGRATOR_H
+#define CPHYSICS_INTEGRATOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "entity.h"
+
+/**
+ * @brief Compute the acceleration of every entity from the current positions and velocities
+ *
+ * Accelerations are zeroed by the integrator before each call, the callback only accumulates into them
+ * (apply_universal_gravitation, apply_electric_field, ...).
+ */
+typedef void (*AccelerationFn)(Entity* entities, size_t count, void* user);
+
+typedef enum {
+    INTEGRATOR_EULER,           // explicit Euler, 1 force evaluation per step, first order
+    INTEGRATOR_VELOCITY_VERLET, // leapfrog kick-drift-kick, 1 evaluation per step, second order symplectic
+    INTEGRATOR_YOSHIDA4,        // Forest-Ruth / Yoshida composition of three Verlet steps, 3 evaluations, fourth order symplectic
+    INTEGRATOR_DORMAND_PRINCE   // embedded Runge-Kutta 5(4) with error controlled substeps, FSAL
+} IntegratorType;
+
+/**
+ * @brief Integrator state, reuse one per simulation so scratch memory is allocated once
+ */
+typedef struct Integrator {
+    IntegratorType type;
+    AccelerationFn accelerations;
+    void* user;
+
+    double abs_tol;     // adaptive only
+    double rel_tol;
+    double dt_min;
+    double dt_max;
+    double dt_next;     // adaptive substep carried between calls
+
+    double* scratch;
+    size_t scratch_capacity;
+    bool accelerations_valid;   // entity accelerations match the current positions
+
+    size_t force_evaluations;
+    size_t steps_accepted;
+    size_t steps_rejected;
+} Integrator;
+
+/**
+ * @brief Initialise an integrator, adaptive tolerances default to 1e-9 relative / 1e-12 absolute
+ *
+ * @return OPERATION_SET_FAILED on NULL integrator or callback
+ */
+ErrorCode integrator_init(Integrator* it, IntegratorType type, AccelerationFn accelerations, void* user);
+
+void integrator_free(Integrator* it);
+
+/**
+ * @brief Advance the translational state of all non static entities by dt
+ *
+ * Dormand-Prince covers dt with as many error controlled substeps as needed.
+ * Call integrator_invalidate after modifying entity positions outside the integrator.
+ *
+ * @return OPERATION_SET_FAILED if dt is not positive and finite, or if Dormand-Prince meets a non-finite error
+ *         estimate or rejects 64 substeps in a row; entities then hold the last accepted substep
+ */
+ErrorCode integrator_step(Integrator* it, Entity* entities, size_t count, double dt);
+
+void integrator_invalidate(Integrator* it);
+
+/**
+ * @brief Pairwise universal gravitation between all entities, usable as AccelerationFn
+ */
+void integrator_gravity_accelerations(Entity* entities, size_t count, void* user);
+
+/**
+ * @brief Kinetic plus gravitational potential energy, for measuring integrator drift
+ */
+double gravity_system_energy(const Entity* entities, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_INTEGRATOR_H
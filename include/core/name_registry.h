@@ -0,0 +1,76 @@
+#ifndef CPHYSICS_NAME_REGISTRY_H
+#define CPHYSICS_NAME_REGISTRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t NameId;
+
+// id of the empty name, also used for entities created without a name
+#define NAME_ID_NONE 0u
+
+typedef enum {
+    NAME_REGISTRY_SUCCESS = 0,
+    NAME_REGISTRY_ERROR_NULL_POINTER,
+    NAME_REGISTRY_ERROR_NOT_FOUND,
+    NAME_REGISTRY_ERROR_FULL,
+    NAME_REGISTRY_ERROR_OUT_OF_MEMORY
+} NameRegistryErrorCode;
+
+/**
+ * @brief Interned strings with a 32-bit id each
+ *
+ * Strings are copied once into large arena blocks and never move, so pointers returned by name_registry_str
+ * stay valid until name_registry_destroy. Lookup by name goes through an open-addressing hash table (linear
+ * probing, at most half full). All functions may be called from any thread: interning and lookups by name are
+ * serialised by a lock, name_registry_str does not take it.
+ */
+typedef struct NameRegistry NameRegistry;
+
+/**
+ * @brief New empty registry, NULL when out of memory
+ */
+NameRegistry* name_registry_create(void);
+void name_registry_destroy(NameRegistry* reg);
+
+/**
+ * @brief Id of a name, adding it on first use
+ *
+ * NULL and "" are NAME_ID_NONE.
+ */
+NameRegistryErrorCode name_registry_intern(NameRegistry* reg, const char* name, NameId* id);
+
+/**
+ * @brief Same as name_registry_intern for the first len bytes of name, which need not be null terminated
+ */
+NameRegistryErrorCode name_registry_intern_n(NameRegistry* reg, const char* name, size_t len, NameId* id);
+
+/**
+ * @brief Id of a name that was interned before, without adding it
+ */
+NameRegistryErrorCode name_registry_find(NameRegistry* reg, const char* name, NameId* id);
+
+/**
+ * @brief Interned string of an id, "" for unknown ids
+ */
+const char* name_registry_str(NameRegistry* reg, NameId id);
+
+/**
+ * @brief Number of distinct names, the empty name included
+ */
+size_t name_registry_count(NameRegistry* reg);
+
+/**
+ * @brief Process-wide registry used by new_entity, created on first use
+ */
+NameRegistry* name_registry_default(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_NAME_REGISTRY_H
@@ -0,0 +1,102 @@
+#ifndef CPHYSICS_NARROWPHASE_H
+#define CPHYSICS_NARROWPHASE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "entity.h"
+#include "shape.h"
+
+/**
+ * @brief Contact between two bodies
+ *
+ * The normal points from the first body of the pair towards the second, the point lies halfway between the two
+ * surfaces. depth > 0 means the bodies overlap, depth <= 0 means they are separated (for box pairs the magnitude
+ * is then only a lower bound of the distance).
+ */
+typedef struct Contact {
+    Vector point;
+    Vector normal;
+    double depth;
+} Contact;
+
+typedef enum {
+    CONTACT_SPHERE_SPHERE,      // points count as spheres of radius 0
+    CONTACT_SPHERE_BOX,
+    CONTACT_SPHERE_CYLINDER,
+    CONTACT_BOX_BOX,            // separating axis test over the 15 axes
+    CONTACT_PAIR_COUNT
+} ContactPairType;
+
+typedef enum {
+    NARROWPHASE_SUCCESS = 0,
+    NARROWPHASE_ERROR_NULL_POINTER,
+    NARROWPHASE_ERROR_UNSUPPORTED_PAIR, // cylinder-cylinder and box-cylinder
+    NARROWPHASE_ERROR_OUT_OF_MEMORY
+} NarrowPhaseErrorCode;
+
+/**
+ * @brief Pairs of one shape combination, stored column by column
+ *
+ * columns[f * capacity + i] holds field f of pair i: the gathered geometry of both bodies followed by the
+ * contact outputs, so every kernel reads and writes contiguous arrays.
+ */
+typedef struct ContactBatch {
+    size_t count;
+    size_t capacity;
+    double* columns;
+    size_t* pair;               // index of the pair in add order
+    unsigned char* swapped;     // shapes were reordered, the normal is flipped back on output
+} ContactBatch;
+
+/**
+ * @brief Batched narrow phase, reuse one across frames so buffers are allocated once
+ *
+ * Shapes follow the basic_obj conventions: boxes have half extents (width, height, width) / 2 and cylinders
+ * their axis along the local y axis, both oriented by the entity quaternion.
+ */
+typedef struct NarrowPhase {
+    ContactBatch batches[CONTACT_PAIR_COUNT];
+    Contact* contacts;          // one per added pair, filled by narrowphase_run
+    size_t pair_count;
+    size_t pair_capacity;
+} NarrowPhase;
+
+NarrowPhaseErrorCode narrowphase_init(NarrowPhase* np);
+void narrowphase_free(NarrowPhase* np);
+
+/**
+ * @brief Drop all pairs, keeps the buffers
+ */
+void narrowphase_clear(NarrowPhase* np);
+
+/**
+ * @brief Gather the geometry of a pair into the batch of its shape combination
+ *
+ * The entities are read now, later changes do not affect the pair.
+ *
+ * @param pair_index Optional, receives the index of the pair in contacts
+ */
+NarrowPhaseErrorCode narrowphase_add(NarrowPhase* np, const Entity* a, const SceneShape* shape_a,
+                                     const Entity* b, const SceneShape* shape_b, size_t* pair_index);
+
+/**
+ * @brief Run every batch through its kernel and fill contacts
+ *
+ * @return The number of overlapping pairs
+ */
+size_t narrowphase_run(NarrowPhase* np);
+
+/**
+ * @brief Contact of a single pair, for callers without a batch
+ */
+NarrowPhaseErrorCode narrowphase_collide(const Entity* a, const SceneShape* shape_a,
+                                         const Entity* b, const SceneShape* shape_b, Contact* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_NARROWPHASE_H
@@ -0,0 +1,299 @@
+#ifndef CPHYSICS_POTENTIAL_H
+#define CPHYSICS_POTENTIAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "entity.h"
+#include "../mathlib/vec_math.h"
+
+// pair loops over fewer bodies run on one thread
+#define POTENTIAL_PARALLEL_THRESHOLD 512
+
+typedef enum {
+    POTENTIAL_SUCCESS = 0,
+    POTENTIAL_ERROR_NULL_POINTER,
+    POTENTIAL_ERROR_INVALID_PARAMS,
+    POTENTIAL_ERROR_UNKNOWN_TYPE,
+    POTENTIAL_ERROR_OUT_OF_MEMORY
+} PotentialErrorCode;
+
+/**
+ * @brief Parameters of every built-in potential, each one reads only its own fields
+ */
+typedef struct PotentialParams {
+    double cutoff;      // pairs at or beyond this distance are skipped
+    double epsilon;     // Lennard-Jones well depth (J)
+    double sigma;       // Lennard-Jones zero crossing (m)
+    double strength;    // Yukawa prefactor, U = strength q_i q_j exp(-kappa r) / r
+    double kappa;       // Yukawa inverse screening length (1/m)
+    double modulus;     // Hertz effective Young's modulus E* (Pa)
+} PotentialParams;
+
+/*
+ * Pair functions return F(r) / r for two bodies at squared distance r2, positive when repulsive, and store the
+ * pair energy in *energy. They receive both charges and both radii so the loops that call them stay uniform.
+ * They must be branch free: they are inlined into SIMD loops and evaluated for pairs outside the cutoff too,
+ * whose results are discarded.
+ */
+
+/**
+ * @brief Lennard-Jones 12-6, U = 4 epsilon ((sigma/r)^12 - (sigma/r)^6)
+ */
+static inline double potential_lennard_jones_pair(double r2, double qi, double qj, double ri, double rj,
+                                                  const PotentialParams* p, double* energy) {
+    (void)qi; (void)qj; (void)ri; (void)rj;
+    double inv_r2 = 1.0 / r2;
+    double s2 = p->sigma * p->sigma * inv_r2;
+    double s6 = s2 * s2 * s2;
+    double s12 = s6 * s6;
+    *energy = 4.0 * p->epsilon * (s12 - s6);
+    return 24.0 * p->epsilon * (2.0 * s12 - s6) * inv_r2;
+}
+
+/**
+ * @brief Screened Coulomb (Yukawa), U = strength q_i q_j exp(-kappa r) / r
+ */
+static inline double potential_yukawa_pair(double r2, double qi, double qj, double ri, double rj,
+                                           const PotentialParams* p, double* energy) {
+    (void)ri; (void)rj;
+    double r = sqrt(r2);
+    double u = p->strength * qi * qj * vm_exp(-p->kappa * r) / r;
+    *energy = u;
+    return u * (1.0 + p->kappa * r) / r2;
+}
+
+/**
+ * @brief Hertzian elastic contact of spheres, U = 8/15 E* sqrt(R*) delta^(5/2) with overlap delta = r_i + r_j - r
+ */
+static inline double potential_hertz_pair(double r2, double qi, double qj, double ri, double rj,
+                                          const PotentialParams* p, double* energy) {
+    (void)qi; (void)qj;
+    double r = sqrt(r2);
+    double rsum = ri + rj;
+    double overlap = rsum - r;
+    overlap = overlap > 0.0 ? overlap : 0.0;
+    double reduced = rsum > 0.0 ? ri * rj / rsum : 0.0;
+    double k = p->modulus * sqrt(reduced > 0.0 ? reduced : 0.0);
+    double f = 4.0 / 3.0 * k * overlap * sqrt(overlap);
+    *energy = 0.4 * f * overlap;
+    return f / r;
+}
+
+/**
+ * @brief Built-in potentials, X(name, NAME) with potential_<name>_pair defined above
+ */
+#define CPHYSICS_POTENTIALS(X) \
+    X(lennard_jones, LENNARD_JONES) \
+    X(yukawa, YUKAWA) \
+    X(hertz, HERTZ)
+
+typedef enum {
+#define CPHYSICS_POTENTIAL_ENUM(name, NAME) POTENTIAL_##NAME,
+    CPHYSICS_POTENTIALS(CPHYSICS_POTENTIAL_ENUM)
+#undef CPHYSICS_POTENTIAL_ENUM
+    POTENTIAL_COUNT
+} PotentialType;
+
+/**
+ * @brief Structure of arrays copy of the bodies a pair loop works on
+ */
+typedef struct PairSystem {
+    size_t count;
+    size_t capacity;
+    double* x;
+    double* y;
+    double* z;
+    double* charge;
+    double* radius;
+    double* inv_mass;           // 0 for static and massless bodies
+    double* ax;                 // accelerations written by the kernels
+    double* ay;
+    double* az;
+    double energy;              // potential energy accumulated by the kernels
+} PairSystem;
+
+/**
+ * @brief Full (both directions) Verlet list in compressed rows, built from a cell grid
+ *
+ * Pairs closer than cutoff + skin are listed, so the list stays valid until some body has moved skin / 2.
+ */
+typedef struct NeighborList {
+    double cutoff;
+    double skin;
+    size_t count;
+    size_t* offsets;            // neighbours of i are neighbors[offsets[i] .. offsets[i + 1]]
+    uint32_t* neighbors;
+    size_t neighbor_capacity;
+    double* reference;          // positions at the last build, 3 per body
+
+    uint32_t* cell_of;
+    uint32_t* cell_start;
+    uint32_t* cell_items;
+    size_t cell_capacity;
+    size_t capacity;
+
+    size_t builds;
+} NeighborList;
+
+/**
+ * @brief Generate the pair loops of a potential from its pair function
+ *
+ * For a function static inline double NAME_pair(r2, qi, qj, ri, rj, const PotentialParams*, double* energy) this
+ * defines
+ *   static void NAME_direct_sum(PairSystem* s, const PotentialParams* p)
+ *   static void NAME_neighbor_list(PairSystem* s, const NeighborList* nl, const PotentialParams* p)
+ * which overwrite s->ax/ay/az and add the potential energy to s->energy. Each is a loop over bodies (OpenMP)
+ * around a SIMD loop over partners, the pair function is inlined in it.
+ */
+#define CPHYSICS_PAIR_KERNELS(NAME)                                                                          \
+static void NAME##_direct_sum(PairSystem* s, const PotentialParams* p) {                                     \
+    const double* restrict x = s->x;                                                                         \
+    const double* restrict y = s->y;                                                                         \
+    const double* restrict z = s->z;                                                                         \
+    const double* restrict q = s->charge;                                                                    \
+    const double* restrict rad = s->radius;                                                                  \
+    long n = (long)s->count;                                                                                 \
+    double rc2 = p->cutoff * p->cutoff;                                                                      \
+    double energy = 0.0;                                                                                     \
+    _Pragma("omp parallel for schedule(dynamic, 16) reduction(+:energy) if(n > POTENTIAL_PARALLEL_THRESHOLD)")\
+    for (long i = 0; i < n; i++) {                                                                           \
+        double xi = x[i], yi = y[i], zi = z[i], qi = q[i], ri = rad[i];                                      \
+        double fx = 0.0, fy = 0.0, fz = 0.0, e = 0.0;                                                        \
+        _Pragma("omp simd reduction(+:fx, fy, fz, e)")                                                       \
+        for (long j = 0; j < n; j++) {                                                                       \
+            double dx = xi - x[j], dy = yi - y[j], dz = zi - z[j];                                           \
+            double r2 = dx * dx + dy * dy + dz * dz;                                                         \
+            bool inside = r2 < rc2 && r2 > 0.0;                                                              \
+            double u;                                                                                        \
+            double f = NAME##_pair(inside ? r2 : rc2, qi, q[j], ri, rad[j], p, &u);                          \
+            f = inside ? f : 0.0;                                                                            \
+            e += inside ? u : 0.0;                                                                           \
+            fx += f * dx;                                                                                    \
+            fy += f * dy;                                                                                    \
+            fz += f * dz;                                                                                    \
+        }                                                                                                    \
+        s->ax[i] = fx * s->inv_mass[i];                                                                      \
+        s->ay[i] = fy * s->inv_mass[i];                                                                      \
+        s->az[i] = fz * s->inv_mass[i];                                                                      \
+        energy += 0.5 * e;                                                                                   \
+    }                                                                                                        \
+    s->energy += energy;                                                                                     \
+}                                                                                                            \
+                                                                                                             \
+static void NAME##_neighbor_list(PairSystem* s, const NeighborList* nl, const PotentialParams* p) {          \
+    const double* restrict x = s->x;                                                                         \
+    const double* restrict y = s->y;                                                                         \
+    const double* restrict z = s->z;                                                                         \
+    const double* restrict q = s->charge;                                                                    \
+    const double* restrict rad = s->radius;                                                                  \
+    const size_t* offsets = nl->offsets;                                                                     \
+    const uint32_t* restrict nb = nl->neighbors;                                                             \
+    long n = (long)s->count;                                                                                 \
+    double rc2 = p->cutoff * p->cutoff;                                                                      \
+    double energy = 0.0;                                                                                     \
+    _Pragma("omp parallel for schedule(static) reduction(+:energy) if(n > POTENTIAL_PARALLEL_THRESHOLD)")    \
+    for (long i = 0; i < n; i++) {                                                                           \
+        double xi = x[i], yi = y[i], zi = z[i], qi = q[i], ri = rad[i];                                      \
+        double fx = 0.0, fy = 0.0, fz = 0.0, e = 0.0;                                                        \
+        long end = (long)offsets[i + 1];                                                                     \
+        _Pragma("omp simd reduction(+:fx, fy, fz, e)")                                                       \
+        for (long k = (long)offsets[i]; k < end; k++) {                                                      \
+            uint32_t j = nb[k];                                                                              \
+            double dx = xi - x[j], dy = yi - y[j], dz = zi - z[j];                                           \
+            double r2 = dx * dx + dy * dy + dz * dz;                                                         \
+            bool inside = r2 < rc2 && r2 > 0.0;                                                              \
+            double u;                                                                                        \
+            double f = NAME##_pair(inside ? r2 : rc2, qi, q[j], ri, rad[j], p, &u);                          \
+            f = inside ? f : 0.0;                                                                            \
+            e += inside ? u : 0.0;                                                                           \
+            fx += f * dx;                                                                                    \
+            fy += f * dy;                                                                                    \
+            fz += f * dz;                                                                                    \
+        }                                                                                                    \
+        s->ax[i] = fx * s->inv_mass[i];                                                                      \
+        s->ay[i] = fy * s->inv_mass[i];                                                                      \
+        s->az[i] = fz * s->inv_mass[i];                                                                      \
+        energy += 0.5 * e;                                                                                   \
+    }                                                                                                        \
+    s->energy += energy;                                                                                     \
+}
+
+/**
+ * @brief Copy positions, charges, radii and inverse masses into s, growing it as needed
+ *
+ * @param radii Optional, one radius per entity, 0 when NULL
+ */
+PotentialErrorCode pair_system_load(PairSystem* s, const Entity* entities, size_t count, const double* radii);
+
+/**
+ * @brief Add the accelerations computed by a kernel to the entities
+ */
+void pair_system_store(const PairSystem* s, Entity* entities);
+void pair_system_free(PairSystem* s);
+
+PotentialErrorCode neighbor_list_init(NeighborList* nl, double cutoff, double skin);
+void neighbor_list_free(NeighborList* nl);
+
+/**
+ * @brief Rebuild the list if the body count changed or a body moved more than skin / 2 since the last build
+ *
+ * @param rebuilt Optional, set to whether the list was rebuilt
+ */
+PotentialErrorCode neighbor_list_update(NeighborList* nl, const PairSystem* s, bool* rebuilt);
+
+/**
+ * @brief A built-in potential ready to be used as AccelerationFn (potential_accelerations)
+ */
+typedef struct PotentialForce {
+    PotentialType type;
+    PotentialParams params;
+    const double* radii;        // optional, required by Hertz with every radius > 0
+    bool use_neighbor_list;     // else all pairs are visited
+    NeighborList neighbors;
+    PairSystem system;
+    double energy;              // potential energy of the last evaluation, 0 if it failed
+    PotentialErrorCode error;   // result of the last evaluation, the only report potential_accelerations gives
+} PotentialForce;
+
+/**
+ * @brief Typical parameters in SI units, cutoff 2.5 sigma for Lennard-Jones and 5 / kappa for Yukawa
+ */
+void potential_default_params(PotentialType type, PotentialParams* params);
+
+/**
+ * @param radii Required by Hertz, potential_apply checks that the first count radii are positive and at most
+ *              cutoff / 2
+ * @param skin Neighbour list margin, ignored without a neighbour list
+ */
+PotentialErrorCode potential_force_init(PotentialForce* force, PotentialType type, const PotentialParams* params,
+                                        const double* radii, bool use_neighbor_list, double skin);
+void potential_force_free(PotentialForce* force);
+
+/**
+ * @brief Add the accelerations caused by the potential to every non static entity
+ *
+ * On failure nothing is added to the entities, energy is 0 and the code is also stored in force->error.
+ *
+ * @return POTENTIAL_ERROR_INVALID_PARAMS for Hertz if a radius is not positive and finite or the cutoff is
+ *         shorter than twice the largest radius
+ */
+PotentialErrorCode potential_apply(PotentialForce* force, Entity* entities, size_t count);
+
+/**
+ * @brief AccelerationFn adapter, user is a PotentialForce
+ *
+ * The callback cannot return an error, check force->error after stepping.
+ */
+void potential_accelerations(Entity* entities, size_t count, void* user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_POTENTIAL_H
@@ -0,0 +1,117 @@
+#ifndef CPHYSICS_REORDER_H
+#define CPHYSICS_REORDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "entity.h"
+
+typedef enum {
+    REORDER_SUCCESS = 0,
+    REORDER_ERROR_NULL_POINTER,
+    REORDER_ERROR_INVALID_CONFIG,
+    REORDER_ERROR_COUNT_MISMATCH,
+    REORDER_ERROR_OUT_OF_MEMORY
+} ReorderErrorCode;
+
+typedef struct ReorderConfig {
+    double locality_threshold;  // reorder_maybe sorts once the metric exceeds this multiple of its post-sort value
+    size_t min_count;           // reorder_maybe leaves smaller arrays alone
+} ReorderConfig;
+
+typedef struct ReorderStats {
+    size_t reorders;
+    size_t checks;              // reorder_maybe calls
+    double locality_before;     // metric of the last reorder, see reorder_locality
+    double locality_after;
+    double last_bounds_ms;      // bounding box
+    double last_key_ms;         // Morton keys
+    double last_sort_ms;        // radix sort
+    double last_permute_ms;     // entities and handle tables
+    double last_total_ms;
+    int key_bits;               // bits per axis of the last sort
+    int sort_passes;            // radix passes actually run, digits equal for every key are skipped
+} ReorderStats;
+
+/**
+ * @brief Keeps entity storage sorted along a Z-order curve and stable handles to the entities
+ *
+ * A handle is the index an entity had when reorder_init was called. Reordering moves entities in place and
+ * updates the handle tables so reorder_index_of keeps finding them. Other arrays indexed like the entities
+ * (shapes, radii) can be permuted the same way with reorder_apply. Cached per-entity state elsewhere, such as a
+ * HardSphereSystem or an integrator's accelerations, has to be rebuilt or invalidated after a reorder.
+ */
+typedef struct EntityReorder {
+    ReorderConfig config;
+    size_t count;
+    uint32_t* handle_to_index;
+    uint32_t* index_to_handle;
+
+    uint64_t* keys;
+    uint64_t* keys_swap;
+    uint32_t* order;            // storage index moved to position i by the last reorder
+    uint32_t* order_swap;
+    void* scratch;              // permutation buffer, grown by reorder_apply
+    size_t scratch_size;
+
+    double baseline;            // locality right after the last reorder, 0 before the first
+    ReorderStats stats;
+} EntityReorder;
+
+/**
+ * @brief Reorder when locality has doubled, arrays below 1024 entities are left alone
+ */
+void reorder_default_config(ReorderConfig* config);
+
+/**
+ * @param config NULL for reorder_default_config
+ * @param count At most UINT32_MAX entities, handle h initially refers to entity h
+ */
+ReorderErrorCode reorder_init(EntityReorder* r, const ReorderConfig* config, size_t count);
+void reorder_free(EntityReorder* r);
+
+/**
+ * @brief Sort entities by the Morton key of their position with a parallel radix sort
+ */
+ReorderErrorCode reorder_run(EntityReorder* r, Entity* entities, size_t count);
+
+/**
+ * @brief Sort only if the locality metric degraded past the threshold or no sort happened yet
+ *
+ * @param reordered Optional, set to whether entities moved
+ */
+ReorderErrorCode reorder_maybe(EntityReorder* r, Entity* entities, size_t count, bool* reordered);
+
+/**
+ * @brief Apply the permutation of the last reorder to another array of count elements of element_size bytes
+ */
+ReorderErrorCode reorder_apply(EntityReorder* r, void* array, size_t element_size);
+
+/**
+ * @brief Current storage index of a handle, SIZE_MAX if out of range
+ */
+size_t reorder_index_of(const EntityReorder* r, size_t handle);
+
+/**
+ * @brief Handle of the entity at a storage index, SIZE_MAX if out of range
+ */
+size_t reorder_handle_of(const EntityReorder* r, size_t index);
+
+/**
+ * @brief Mean distance between entities adjacent in memory, in units of the mean spacing of the bounding box
+ *
+ * Close to 1 for storage that follows space, grows with the cube root of count for random order.
+ */
+double reorder_locality(const Entity* entities, size_t count);
+
+ReorderStats reorder_stats(const EntityReorder* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_REORDER_H
@@ -0,0 +1,54 @@
+#ifndef CPHYSICS_SCENE_LOADER_H
+#define CPHYSICS_SCENE_LOADER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "entity.h"
+#include "shape.h"
+
+typedef enum {
+    SCENE_SUCCESS = 0,
+    SCENE_ERROR_NULL_POINTER,
+    SCENE_ERROR_IO,
+    SCENE_ERROR_CAPACITY,
+    SCENE_ERROR_PARSE
+} SceneErrorCode;
+
+typedef struct SceneLoadError {
+    size_t line;        // 1-based line of the first error
+    int column;         // 1-based field index, 0 when the whole line is wrong
+    char message[128];
+} SceneLoadError;
+
+/**
+ * @brief Count the bodies in a scene file so storage can be preallocated
+ */
+SceneErrorCode scene_count_records(const char* path, size_t* count);
+
+/**
+ * @brief Load a scene file (format in doc/SceneFormat.md) into preallocated storage
+ *
+ * The file is memory-mapped and split into chunks at line boundaries that are parsed in parallel
+ * (OpenMP when available); records are written straight into entities[i] / shapes[i] in file order.
+ *
+ * @param shapes Optional, one entry per entity
+ * @param count Number of bodies loaded
+ * @param error Optional, filled with the first failing line on SCENE_ERROR_PARSE
+ */
+SceneErrorCode scene_load(const char* path, Entity* entities, SceneShape* shapes, size_t capacity,
+                          size_t* count, SceneLoadError* error);
+
+/**
+ * @brief Same as scene_load on an in-memory buffer
+ */
+SceneErrorCode scene_parse_buffer(const char* data, size_t size, Entity* entities, SceneShape* shapes,
+                                  size_t capacity, size_t* count, SceneLoadError* error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_SCENE_LOADER_H
@@ -0,0 +1,32 @@
+#ifndef CPHYSICS_SHAPE_H
+#define CPHYSICS_SHAPE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SHAPE_POINT,
+    SHAPE_SPHERE,
+    SHAPE_CYLINDER,
+    SHAPE_CUBE
+} ShapeType;
+
+/**
+ * @brief Collision shape of a body, matches the dimensions of the basic_obj types
+ *
+ * Used by the scene loader and the narrow phase; sphere_shape, cube_shape and cylinder_shape build one from a
+ * basic_obj body.
+ */
+typedef struct SceneShape {
+    ShapeType type;
+    double radius;  // sphere, cylinder
+    double height;  // cylinder, cube
+    double width;   // cube
+} SceneShape;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_SHAPE_H
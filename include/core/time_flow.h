@@ -5,9 +5,13 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Monotonic clock in milliseconds (CLOCK_MONOTONIC where available), used for timing statistics
+ */
+double wall_clock_ms(void);
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif //CPHYSICS_TIME_FLOW_H
\ No newline at end of file
+#endif //CPHYSICS_TIME_FLOW_H
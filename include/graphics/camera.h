@@ -5,9 +5,43 @@
 extern "C" {
 #endif
 
+#include "../mathlib/Vector.h"
+#include "../error_codes.h"
+
+/**
+ * @brief Pinhole camera looking from position towards target
+ *
+ * forward/right/up are orthonormal and filled by camera_look_at. In a right-handed world, (right, up, forward)
+ * is a left-handed triple: right = forward x up, so view space has x right, y up and z into the screen.
+ */
+typedef struct Camera {
+    Vector position;
+    Vector forward;
+    Vector right;
+    Vector up;
+    double fov_y;   // vertical field of view in radians
+    double near_plane;
+} Camera;
+
+/**
+ * @brief Build a camera at eye looking at target
+ *
+ * @param eye Camera position
+ * @param target Point the camera looks at
+ * @param up Approximate up direction, must not be parallel to target - eye
+ * @param fov_y Vertical field of view in radians
+ */
+Camera new_camera(const Vector* eye, const Vector* target, const Vector* up, double fov_y);
+
+ErrorCode camera_look_at(Camera* cam, const Vector* eye, const Vector* target, const Vector* up);
+
+/**
+ * @brief Transform a world space point into camera space (x right, y up, z forward)
+ */
+Vector camera_to_view(const Camera* cam, const Vector* p);
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif //CPHYSICS_CAMERA_H
\ No newline at end of file
+#endif //CPHYSICS_CAMERA_H
@@ -0,0 +1,108 @@
+#ifndef CPHYSICS_RENDERER_H
+#define CPHYSICS_RENDERER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "camera.h"
+#include "../basic_obj/sphere.h"
+#include "../basic_obj/cylinder.h"
+#include "../basic_obj/cube.h"
+
+/**
+ * @brief RGB + depth framebuffer, rgb is width*height*3 bytes, depth is view space z per pixel
+ */
+typedef struct Framebuffer {
+    int width;
+    int height;
+    unsigned char* rgb;
+    float* depth;
+} Framebuffer;
+
+/**
+ * @brief Bodies to draw in one frame, any of the arrays may be NULL when its count is 0
+ *
+ * Cylinders are aligned with their local y axis, cubes span width along local x/z and height along local y.
+ */
+typedef struct RenderScene {
+    const Sphere* spheres;
+    size_t sphere_count;
+    const Cylinder* cylinders;
+    size_t cylinder_count;
+    const Cube* cubes;
+    size_t cube_count;
+} RenderScene;
+
+/**
+ * @brief Timings of the last rendered frame in milliseconds
+ */
+typedef struct RenderStats {
+    double setup_ms;    // projection of bodies to screen bounds
+    double binning_ms;  // assignment of bodies to tiles
+    double raster_ms;   // parallel per tile ray casting
+    double frame_ms;    // total
+    size_t visible_bodies;
+    size_t tile_refs;
+    int tile_count;
+    int threads;
+} RenderStats;
+
+typedef enum {
+    FRAME_FORMAT_PPM,
+    FRAME_FORMAT_PNG
+} FrameFormat;
+
+struct RenderPrim;
+
+/**
+ * @brief Tiled software renderer, owns its framebuffer and reuses scratch memory between frames
+ */
+typedef struct Renderer {
+    Framebuffer fb;
+    int tile_size;
+    int tiles_x;
+    int tiles_y;
+    struct RenderPrim* prims;
+    size_t prim_capacity;
+    size_t* tile_offsets;
+    size_t* tile_items;
+    size_t item_capacity;
+    uint64_t* sort_keys;
+    size_t sort_capacity;
+    unsigned char background[3];
+    RenderStats stats;
+} Renderer;
+
+ErrorCode renderer_init(Renderer* r, int width, int height, int tile_size);
+void renderer_free(Renderer* r);
+
+/**
+ * @brief Render the scene into the renderer framebuffer
+ *
+ * Bodies are projected and binned into tile_size x tile_size screen tiles, then tiles are ray cast
+ * in parallel (OpenMP when available). With clear == false the frame is composited over the current
+ * framebuffer contents using the existing depth values.
+ *
+ * @return OPERATION_SET_SUCCESS, OPERATION_SET_FAILED on bad arguments or allocation failure
+ */
+ErrorCode renderer_draw(Renderer* r, const Camera* cam, const RenderScene* scene, bool clear);
+
+void renderer_clear(Renderer* r);
+
+ErrorCode framebuffer_write_ppm(const Framebuffer* fb, const char* path);
+ErrorCode framebuffer_write_png(const Framebuffer* fb, const char* path);
+
+/**
+ * @brief Write frame number index of a sequence as <prefix>_<index>.ppm or .png
+ */
+ErrorCode framebuffer_write_frame(const Framebuffer* fb, const char* prefix, int index, FrameFormat format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_RENDERER_H
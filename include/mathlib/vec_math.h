@@ -0,0 +1,305 @@
+#ifndef CPHYSICS_VEC_MATH_H
+#define CPHYSICS_VEC_MATH_H
+
+/**
+ * @brief Header only vector and quaternion math
+ *
+ * Everything is static inline so it folds into the calling loop, Vector keeps its {x, y, z} layout and
+ * quaternions stay plain double[4] (w, x, y, z). 4 wide operations use AVX or SSE2 when the compiler
+ * targets them, define CPHYSICS_NO_SIMD to force the scalar code. All quaternion outputs may alias inputs.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include "Vector.h"
+
+#if !defined(CPHYSICS_NO_SIMD) && defined(__AVX__)
+#define VM_AVX 1
+#include <immintrin.h>
+#elif !defined(CPHYSICS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define VM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ---------- scalar ---------- */
+
+/**
+ * @brief 1/sqrt(x) with a correctly rounded sqrt and one division, not an approximate rsqrt instruction
+ *
+ * Lets callers multiply each component by one reciprocal instead of dividing each by the length.
+ */
+static inline double vm_rsqrt(double x) {
+    return 1.0 / sqrt(x);
+}
+
+/**
+ * @brief e^x without branches or libm calls so loops using it vectorise, within a few ulp of exp
+ *
+ * Results below 2^-1022 flush to 0 and arguments above 709 give +inf.
+ */
+static inline double vm_exp(double x) {
+    const double shifter = 6755399441055744.0;     // 1.5 * 2^52, adding it rounds to an integer
+    double xc = x < -708.39 ? -708.39 : x > 709.0 ? 709.0 : x;
+    double kd = xc * 1.4426950408889634 + shifter;
+    double k = kd - shifter;
+    double r = xc - k * 6.93147180369123816490e-01;
+    r = r - k * 1.90821492927058770002e-10;
+
+    // Taylor series on |r| <= ln(2) / 2
+    double p = 1.0 / 6227020800.0;
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    // the low bits of kd hold k, move k + 1023 into the exponent field for 2^k
+    union { double d; uint64_t i; } u = {kd};
+    u.i = (u.i + 1023) << 52;
+    double y = p * u.d;
+    y = x > 709.0 ? INFINITY : y;
+    return x < -708.39 ? 0.0 : y;
+}
+
+/* ---------- vec3 ---------- */
+
+static inline Vector vec3(double x, double y, double z) {
+    Vector r = {x, y, z};
+    return r;
+}
+
+static inline Vector vec3_add(Vector a, Vector b) {
+    return vec3(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+static inline Vector vec3_sub(Vector a, Vector b) {
+    return vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+static inline Vector vec3_scale(Vector a, double s) {
+    return vec3(a.x * s, a.y * s, a.z * s);
+}
+
+static inline Vector vec3_neg(Vector a) {
+    return vec3(-a.x, -a.y, -a.z);
+}
+
+/**
+ * @brief a + s * b
+ */
+static inline Vector vec3_madd(Vector a, double s, Vector b) {
+    return vec3(a.x + s * b.x, a.y + s * b.y, a.z + s * b.z);
+}
+
+/**
+ * @brief y += a * x in place
+ */
+static inline void vec3_axpy(Vector* y, double a, Vector x) {
+    y->x += a * x.x;
+    y->y += a * x.y;
+    y->z += a * x.z;
+}
+
+static inline double vec3_dot(Vector a, Vector b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline Vector vec3_cross(Vector a, Vector b) {
+    return vec3(a.y * b.z - a.z * b.y,
+                a.z * b.x - a.x * b.z,
+                a.x * b.y - a.y * b.x);
+}
+
+static inline double vec3_length_sq(Vector a) {
+    return vec3_dot(a, a);
+}
+
+static inline double vec3_length(Vector a) {
+    return sqrt(vec3_dot(a, a));
+}
+
+static inline double vec3_distance(Vector a, Vector b) {
+    return vec3_length(vec3_sub(a, b));
+}
+
+/**
+ * @brief Unit vector along a from one sqrt and one division, zero vector stays zero
+ *
+ * @param length Optional, receives |a|
+ */
+static inline Vector vec3_normalize(Vector a, double* length) {
+    double len2 = vec3_dot(a, a);
+    if (len2 > 0.0) {
+        double inv = vm_rsqrt(len2);
+        if (length) *length = len2 * inv;
+        return vec3_scale(a, inv);
+    }
+    if (length) *length = 0.0;
+    return a;
+}
+
+/* ---------- vec4 (double[4]) ---------- */
+
+static inline double vec4_dot(const double a[4], const double b[4]) {
+#if defined(VM_AVX)
+    __m256d p = _mm256_mul_pd(_mm256_loadu_pd(a), _mm256_loadu_pd(b));
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(p), _mm256_extractf128_pd(p, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+#elif defined(VM_SSE2)
+    __m128d s = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(a), _mm_loadu_pd(b)),
+                           _mm_mul_pd(_mm_loadu_pd(a + 2), _mm_loadu_pd(b + 2)));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+#else
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+#endif
+}
+
+static inline void vec4_scale(const double a[4], double s, double out[4]) {
+#if defined(VM_AVX)
+    _mm256_storeu_pd(out, _mm256_mul_pd(_mm256_loadu_pd(a), _mm256_set1_pd(s)));
+#elif defined(VM_SSE2)
+    __m128d vs = _mm_set1_pd(s);
+    __m128d lo = _mm_mul_pd(_mm_loadu_pd(a), vs);
+    __m128d hi = _mm_mul_pd(_mm_loadu_pd(a + 2), vs);
+    _mm_storeu_pd(out, lo);
+    _mm_storeu_pd(out + 2, hi);
+#else
+    out[0] = a[0] * s; out[1] = a[1] * s; out[2] = a[2] * s; out[3] = a[3] * s;
+#endif
+}
+
+/**
+ * @brief y += a * x in place
+ */
+static inline void vec4_axpy(double y[4], double a, const double x[4]) {
+#if defined(VM_AVX)
+    _mm256_storeu_pd(y, _mm256_add_pd(_mm256_loadu_pd(y), _mm256_mul_pd(_mm256_set1_pd(a), _mm256_loadu_pd(x))));
+#elif defined(VM_SSE2)
+    __m128d va = _mm_set1_pd(a);
+    _mm_storeu_pd(y, _mm_add_pd(_mm_loadu_pd(y), _mm_mul_pd(va, _mm_loadu_pd(x))));
+    _mm_storeu_pd(y + 2, _mm_add_pd(_mm_loadu_pd(y + 2), _mm_mul_pd(va, _mm_loadu_pd(x + 2))));
+#else
+    y[0] += a * x[0]; y[1] += a * x[1]; y[2] += a * x[2]; y[3] += a * x[3];
+#endif
+}
+
+/* ---------- quaternion (w, x, y, z) ---------- */
+
+static inline void quat_identity(double q[4]) {
+    q[0] = 1.0; q[1] = 0.0; q[2] = 0.0; q[3] = 0.0;
+}
+
+static inline void quat_conj(const double q[4], double out[4]) {
+    out[0] = q[0]; out[1] = -q[1]; out[2] = -q[2]; out[3] = -q[3];
+}
+
+/**
+ * @brief Hamilton product out = a * b
+ */
+static inline void quat_mul(const double a[4], const double b[4], double out[4]) {
+#if defined(VM_AVX)
+    __m256d vb = _mm256_loadu_pd(b);                      // b0 b1 b2 b3
+    __m256d b1 = _mm256_permute_pd(vb, 0x5);              // b1 b0 b3 b2
+    __m256d b2 = _mm256_permute2f128_pd(vb, vb, 0x1);     // b2 b3 b0 b1
+    __m256d b3 = _mm256_permute_pd(b2, 0x5);              // b3 b2 b1 b0
+    // _mm256_set_pd lists lanes 3..0
+    const __m256d s1 = _mm256_set_pd(0.0, -0.0, 0.0, -0.0);
+    const __m256d s2 = _mm256_set_pd(-0.0, 0.0, 0.0, -0.0);
+    const __m256d s3 = _mm256_set_pd(0.0, 0.0, -0.0, -0.0);
+    __m256d r = _mm256_mul_pd(_mm256_broadcast_sd(&a[0]), vb);
+    r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_broadcast_sd(&a[1]), _mm256_xor_pd(b1, s1)));
+    r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_broadcast_sd(&a[2]), _mm256_xor_pd(b2, s2)));
+    r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_broadcast_sd(&a[3]), _mm256_xor_pd(b3, s3)));
+    _mm256_storeu_pd(out, r);
+#elif defined(VM_SSE2)
+    __m128d lo = _mm_loadu_pd(b);                 // b0 b1
+    __m128d hi = _mm_loadu_pd(b + 2);             // b2 b3
+    __m128d lo_sw = _mm_shuffle_pd(lo, lo, 1);    // b1 b0
+    __m128d hi_sw = _mm_shuffle_pd(hi, hi, 1);    // b3 b2
+    // _mm_set_pd lists lanes 1..0
+    const __m128d neg_lo = _mm_set_pd(0.0, -0.0);
+    const __m128d neg_hi = _mm_set_pd(-0.0, 0.0);
+    const __m128d neg_both = _mm_set1_pd(-0.0);
+    __m128d a0 = _mm_set1_pd(a[0]), a1 = _mm_set1_pd(a[1]);
+    __m128d a2 = _mm_set1_pd(a[2]), a3 = _mm_set1_pd(a[3]);
+
+    __m128d r_lo = _mm_mul_pd(a0, lo);
+    r_lo = _mm_add_pd(r_lo, _mm_mul_pd(a1, _mm_xor_pd(lo_sw, neg_lo)));   // -b1  b0
+    r_lo = _mm_add_pd(r_lo, _mm_mul_pd(a2, _mm_xor_pd(hi, neg_lo)));      // -b2  b3
+    r_lo = _mm_add_pd(r_lo, _mm_mul_pd(a3, _mm_xor_pd(hi_sw, neg_both))); // -b3 -b2
+
+    __m128d r_hi = _mm_mul_pd(a0, hi);
+    r_hi = _mm_add_pd(r_hi, _mm_mul_pd(a1, _mm_xor_pd(hi_sw, neg_lo)));   // -b3  b2
+    r_hi = _mm_add_pd(r_hi, _mm_mul_pd(a2, _mm_xor_pd(lo, neg_hi)));      //  b0 -b1
+    r_hi = _mm_add_pd(r_hi, _mm_mul_pd(a3, lo_sw));                       //  b1  b0
+
+    _mm_storeu_pd(out, r_lo);
+    _mm_storeu_pd(out + 2, r_hi);
+#else
+    double w = a[0]*b[0] - a[1]*b[1] - a[2]*b[2] - a[3]*b[3];
+    double x = a[0]*b[1] + a[1]*b[0] + a[2]*b[3] - a[3]*b[2];
+    double y = a[0]*b[2] - a[1]*b[3] + a[2]*b[0] + a[3]*b[1];
+    double z = a[0]*b[3] + a[1]*b[2] - a[2]*b[1] + a[3]*b[0];
+    out[0] = w; out[1] = x; out[2] = y; out[3] = z;
+#endif
+}
+
+/**
+ * @brief Scale q to unit length, quaternions shorter than 1e-10 are left untouched
+ */
+static inline void quat_normalize(double q[4]) {
+    double len2 = vec4_dot(q, q);
+    if (len2 > 1e-20) {
+        vec4_scale(q, vm_rsqrt(len2), q);
+    }
+}
+
+/**
+ * @brief Rotate v by the unit quaternion q, v' = v + w t + u x t with t = 2 u x v
+ *
+ * q must have unit norm. For other q the result is q v q* - (|q|^2 - 1) v, neither a rotation nor the
+ * quaternion product; rotate_vector_by_quaternion computes q v q* for any q.
+ */
+static inline Vector quat_rotate(const double q[4], Vector v) {
+    Vector u = vec3(q[1], q[2], q[3]);
+    Vector t = vec3_scale(vec3_cross(u, v), 2.0);
+    return vec3_add(vec3_madd(v, q[0], t), vec3_cross(u, t));
+}
+
+static inline void quat_from_axis_angle(Vector axis, double angle, double q[4]) {
+    double s = sin(0.5 * angle);
+    q[0] = cos(0.5 * angle);
+    q[1] = axis.x * s;
+    q[2] = axis.y * s;
+    q[3] = axis.z * s;
+    quat_normalize(q);
+}
+
+/**
+ * @brief q += 0.5 dt (omega, 0) * q, then renormalise
+ */
+static inline void quat_integrate(double q[4], Vector omega, double dt) {
+    const double w[4] = {0.0, omega.x, omega.y, omega.z};
+    double dq[4];
+    quat_mul(w, q, dq);
+    vec4_axpy(q, 0.5 * dt, dq);
+    quat_normalize(q);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CPHYSICS_VEC_MATH_H
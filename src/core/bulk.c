@@ -0,0 +1,139 @@
+#include "../../include/core/bulk.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdalign.h>
+
+static const size_t column_offsets[ENTITY_COLUMN_COUNT] = {
+    offsetof(Entity, position),
+    offsetof(Entity, velocity),
+    offsetof(Entity, acceleration),
+    offsetof(Entity, mass),
+    offsetof(Entity, charge),
+    offsetof(Entity, quaternion),
+    offsetof(Entity, angular_velocity)
+};
+
+static const size_t column_components[ENTITY_COLUMN_COUNT] = {3, 3, 3, 1, 1, 4, 3};
+
+// parallel copies only pay off once the column no longer fits in cache
+#define BULK_PARALLEL_THRESHOLD 65536
+
+void entity_layout(EntityLayout* layout) {
+    if (!layout) return;
+    layout->size = sizeof(Entity);
+    layout->alignment = alignof(Entity);
+    for (int c = 0; c < ENTITY_COLUMN_COUNT; c++) {
+        layout->offsets[c] = column_offsets[c];
+        layout->components[c] = column_components[c];
+    }
+}
+
+ErrorCode bulk_borrow_entities(void* memory, size_t bytes, size_t count, Entity** entities) {
+    if (!memory || !entities) {
+        return ENTITY_VOID_ERROR;
+    }
+    if ((uintptr_t)memory % alignof(Entity) != 0 || bytes / sizeof(Entity) < count) {
+        return OPERATION_GET_FAILED;
+    }
+    *entities = (Entity*)memory;
+    return OPERATION_GET_SUCCESS;
+}
+
+ErrorCode bulk_column_view(Entity* entities, size_t count, EntityColumn column, ColumnView* view) {
+    if (!entities || !view) {
+        return ENTITY_VOID_ERROR;
+    }
+    if ((unsigned)column >= ENTITY_COLUMN_COUNT) {
+        return OPERATION_GET_FAILED;
+    }
+    view->data = (double*)((char*)entities + column_offsets[column]);
+    view->count = count;
+    view->components = column_components[column];
+    view->stride = (ptrdiff_t)(sizeof(Entity) / sizeof(double));
+    view->component_stride = 1;
+    return OPERATION_GET_SUCCESS;
+}
+
+ErrorCode bulk_get_column(const Entity* entities, size_t count, EntityColumn column,
+                          double* out, ptrdiff_t stride, ptrdiff_t component_stride) {
+    if (!entities || !out) {
+        return ENTITY_VOID_ERROR;
+    }
+    if ((unsigned)column >= ENTITY_COLUMN_COUNT) {
+        return OPERATION_GET_FAILED;
+    }
+
+    size_t offset = column_offsets[column];
+    size_t k = column_components[column];
+    long n = (long)count;
+
+    if (stride == (ptrdiff_t)k && component_stride == 1) {
+        #pragma omp parallel for schedule(static) if(n > BULK_PARALLEL_THRESHOLD)
+        for (long i = 0; i < n; i++) {
+            const double* src = (const double*)((const char*)&entities[i] + offset);
+            double* dst = out + (size_t)i * k;
+            for (size_t c = 0; c < k; c++) dst[c] = src[c];
+        }
+    } else {
+        #pragma omp parallel for schedule(static) if(n > BULK_PARALLEL_THRESHOLD)
+        for (long i = 0; i < n; i++) {
+            const double* src = (const double*)((const char*)&entities[i] + offset);
+            double* dst = out + i * stride;
+            for (size_t c = 0; c < k; c++) dst[(ptrdiff_t)c * component_stride] = src[c];
+        }
+    }
+
+    return OPERATION_GET_SUCCESS;
+}
+
+ErrorCode bulk_set_column(Entity* entities, size_t count, EntityColumn column,
+                          const double* in, ptrdiff_t stride, ptrdiff_t component_stride) {
+    if (!entities || !in) {
+        return ENTITY_VOID_ERROR;
+    }
+    if ((unsigned)column >= ENTITY_COLUMN_COUNT) {
+        return OPERATION_SET_FAILED;
+    }
+
+    size_t offset = column_offsets[column];
+    size_t k = column_components[column];
+    long n = (long)count;
+
+    if (stride == (ptrdiff_t)k && component_stride == 1) {
+        #pragma omp parallel for schedule(static) if(n > BULK_PARALLEL_THRESHOLD)
+        for (long i = 0; i < n; i++) {
+            double* dst = (double*)((char*)&entities[i] + offset);
+            const double* src = in + (size_t)i * k;
+            for (size_t c = 0; c < k; c++) dst[c] = src[c];
+        }
+    } else {
+        #pragma omp parallel for schedule(static) if(n > BULK_PARALLEL_THRESHOLD)
+        for (long i = 0; i < n; i++) {
+            double* dst = (double*)((char*)&entities[i] + offset);
+            const double* src = in + i * stride;
+            for (size_t c = 0; c < k; c++) dst[c] = src[(ptrdiff_t)c * component_stride];
+        }
+    }
+
+    return OPERATION_SET_SUCCESS;
+}
+
+ErrorCode bulk_get_view(const Entity* entities, EntityColumn column, const ColumnView* out) {
+    if (!out) {
+        return ENTITY_VOID_ERROR;
+    }
+    if ((unsigned)column < ENTITY_COLUMN_COUNT && out->components != column_components[column]) {
+        return OPERATION_GET_FAILED;
+    }
+    return bulk_get_column(entities, out->count, column, out->data, out->stride, out->component_stride);
+}
+
+ErrorCode bulk_set_view(Entity* entities, EntityColumn column, const ColumnView* in) {
+    if (!in) {
+        return ENTITY_VOID_ERROR;
+    }
+    if ((unsigned)column < ENTITY_COLUMN_COUNT && in->components != column_components[column]) {
+        return OPERATION_SET_FAILED;
+    }
+    return bulk_set_column(entities, in->count, column, in->data, in->stride, in->component_stride);
+}
@@ -1,5 +1,6 @@
 #include "../../include/core/collider.h"
 #include <math.h>
+#include "../../include/mathlib/vec_math.h"
 
 void process_collision(Entity* obj_1, Entity* obj_2, double* loss) {
 
@@ -8,34 +9,22 @@ void process_collision(Entity* obj_1, Entity* obj_2, double* loss) {
         return;
     }
     
-    Vector normal;
-    normal.x = obj_2->position.x - obj_1->position.x;
-    normal.y = obj_2->position.y - obj_1->position.y;
-    normal.z = obj_2->position.z - obj_1->position.z;
-    
-    double distance = normalize(normal);
+    double distance;
+    Vector normal = vec3_normalize(vec3_sub(obj_2->position, obj_1->position), &distance);
     
     if (distance == 0) {
         if (loss) *loss = 0.0;
         return;
     }
     
-    normal.x /= distance;
-    normal.y /= distance;
-    normal.z /= distance;
-    
     if (obj_1->is_static || obj_2->is_static) {
         Entity* dynamic_obj = obj_1->is_static ? obj_2 : obj_1;
         Entity* static_obj = obj_1->is_static ? obj_1 : obj_2;
         
         double separation_distance = 0.1;
-        dynamic_obj->position.x -= separation_distance * normal.x;
-        dynamic_obj->position.y -= separation_distance * normal.y;
-        dynamic_obj->position.z -= separation_distance * normal.z;
+        vec3_axpy(&dynamic_obj->position, -separation_distance, normal);
         
-        double vn = dynamic_obj->velocity.x * normal.x + 
-                   dynamic_obj->velocity.y * normal.y + 
-                   dynamic_obj->velocity.z * normal.z;
+        double vn = vec3_dot(dynamic_obj->velocity, normal);
         
         double restitution = dynamic_obj->coefficient_of_restitution;
         double new_vn = -vn * restitution;
@@ -44,21 +33,12 @@ void process_collision(Entity* obj_1, Entity* obj_2, double* loss) {
             *loss = 0.5 * dynamic_obj->mass * (vn*vn - new_vn*new_vn);
         }
         
-        dynamic_obj->velocity.x += (new_vn - vn) * normal.x;
-        dynamic_obj->velocity.y += (new_vn - vn) * normal.y;
-        dynamic_obj->velocity.z += (new_vn - vn) * normal.z;
+        vec3_axpy(&dynamic_obj->velocity, new_vn - vn, normal);
         
         return;
     }
     
-    Vector relative_velocity;
-    relative_velocity.x = obj_2->velocity.x - obj_1->velocity.x;
-    relative_velocity.y = obj_2->velocity.y - obj_1->velocity.y;
-    relative_velocity.z = obj_2->velocity.z - obj_1->velocity.z;
-    
-    double v_rel = relative_velocity.x * normal.x + 
-                  relative_velocity.y * normal.y + 
-                  relative_velocity.z * normal.z;
+    double v_rel = vec3_dot(vec3_sub(obj_2->velocity, obj_1->velocity), normal);
     
     if (v_rel > 0) {
         if (loss) *loss = 0.0;
@@ -69,13 +49,8 @@ void process_collision(Entity* obj_1, Entity* obj_2, double* loss) {
     double separation_factor_1 = obj_2->mass / (obj_1->mass + obj_2->mass);
     double separation_factor_2 = obj_1->mass / (obj_1->mass + obj_2->mass);
     
-    obj_1->position.x -= separation_distance * separation_factor_1 * normal.x;
-    obj_1->position.y -= separation_distance * separation_factor_1 * normal.y;
-    obj_1->position.z -= separation_distance * separation_factor_1 * normal.z;
-    
-    obj_2->position.x += separation_distance * separation_factor_2 * normal.x;
-    obj_2->position.y += separation_distance * separation_factor_2 * normal.y;
-    obj_2->position.z += separation_distance * separation_factor_2 * normal.z;
+    vec3_axpy(&obj_1->position, -separation_distance * separation_factor_1, normal);
+    vec3_axpy(&obj_2->position, separation_distance * separation_factor_2, normal);
     
     double restitution = (obj_1->coefficient_of_restitution < obj_2->coefficient_of_restitution) ?
                         obj_1->coefficient_of_restitution : obj_2->coefficient_of_restitution;
@@ -84,49 +59,76 @@ void process_collision(Entity* obj_1, Entity* obj_2, double* loss) {
     double denominator = (1.0/obj_1->mass + 1.0/obj_2->mass);
     double impulse_magnitude = numerator / denominator;
     
-    Vector impulse;
-    impulse.x = impulse_magnitude * normal.x;
-    impulse.y = impulse_magnitude * normal.y;
-    impulse.z = impulse_magnitude * normal.z;
+    double ke_before = 0.0;
+    if (loss) {
+        ke_before = 0.5 * obj_1->mass * vec3_length_sq(obj_1->velocity) +
+                    0.5 * obj_2->mass * vec3_length_sq(obj_2->velocity);
+    }
+
+    vec3_axpy(&obj_1->velocity, -impulse_magnitude / obj_1->mass, normal);
+    vec3_axpy(&obj_2->velocity, impulse_magnitude / obj_2->mass, normal);
 
     if (loss) {
-        Vector v1_before = obj_1->velocity;
-        Vector v2_before = obj_2->velocity;
-
-        double ke_before = 0.5 * obj_1->mass *
-                          (v1_before.x*v1_before.x +
-                           v1_before.y*v1_before.y +
-                           v1_before.z*v1_before.z) +
-                         0.5 * obj_2->mass *
-                          (v2_before.x*v2_before.x +
-                           v2_before.y*v2_before.y +
-                           v2_before.z*v2_before.z);
-
-        obj_1->velocity.x -= impulse.x / obj_1->mass;
-        obj_1->velocity.y -= impulse.y / obj_1->mass;
-        obj_1->velocity.z -= impulse.z / obj_1->mass;
-
-        obj_2->velocity.x += impulse.x / obj_2->mass;
-        obj_2->velocity.y += impulse.y / obj_2->mass;
-        obj_2->velocity.z += impulse.z / obj_2->mass;
-
-        double ke_after = 0.5 * obj_1->mass *
-                         (obj_1->velocity.x*obj_1->velocity.x +
-                          obj_1->velocity.y*obj_1->velocity.y +
-                          obj_1->velocity.z*obj_1->velocity.z) +
-                         0.5 * obj_2->mass *
-                         (obj_2->velocity.x*obj_2->velocity.x +
-                          obj_2->velocity.y*obj_2->velocity.y +
-                          obj_2->velocity.z*obj_2->velocity.z);
+        double ke_after = 0.5 * obj_1->mass * vec3_length_sq(obj_1->velocity) +
+                          0.5 * obj_2->mass * vec3_length_sq(obj_2->velocity);
+        *loss = ke_before - ke_after;
+    }
+}
+
+double apply_restitution_impulse(Entity* obj_1, Entity* obj_2, const Vector* normal, double* loss) {
+    if (loss) *loss = 0.0;
+    if (!obj_1 || !obj_2 || !normal) {
+        return 0.0;
+    }
+
+    double inv_1 = obj_1->is_static || obj_1->mass <= 0.0 ? 0.0 : 1.0 / obj_1->mass;
+    double inv_2 = obj_2->is_static || obj_2->mass <= 0.0 ? 0.0 : 1.0 / obj_2->mass;
+    double inv_sum = inv_1 + inv_2;
+    if (inv_sum == 0.0) {
+        return 0.0;
+    }
+
+    double v_rel = vec3_dot(vec3_sub(obj_2->velocity, obj_1->velocity), *normal);
+    if (v_rel >= 0.0) {
+        return 0.0;
+    }
 
+    double restitution = (obj_1->coefficient_of_restitution < obj_2->coefficient_of_restitution) ?
+                        obj_1->coefficient_of_restitution : obj_2->coefficient_of_restitution;
+    double impulse_magnitude = -(1.0 + restitution) * v_rel / inv_sum;
+
+    double ke_before = 0.0;
+    if (loss) {
+        ke_before = 0.5 * obj_1->mass * vec3_length_sq(obj_1->velocity) * (inv_1 > 0.0) +
+                    0.5 * obj_2->mass * vec3_length_sq(obj_2->velocity) * (inv_2 > 0.0);
+    }
+
+    vec3_axpy(&obj_1->velocity, -impulse_magnitude * inv_1, *normal);
+    vec3_axpy(&obj_2->velocity, impulse_magnitude * inv_2, *normal);
+
+    if (loss) {
+        double ke_after = 0.5 * obj_1->mass * vec3_length_sq(obj_1->velocity) * (inv_1 > 0.0) +
+                          0.5 * obj_2->mass * vec3_length_sq(obj_2->velocity) * (inv_2 > 0.0);
         *loss = ke_before - ke_after;
-    } else {
-        obj_1->velocity.x -= impulse.x / obj_1->mass;
-        obj_1->velocity.y -= impulse.y / obj_1->mass;
-        obj_1->velocity.z -= impulse.z / obj_1->mass;
-
-        obj_2->velocity.x += impulse.x / obj_2->mass;
-        obj_2->velocity.y += impulse.y / obj_2->mass;
-        obj_2->velocity.z += impulse.z / obj_2->mass;
     }
+    return impulse_magnitude;
+}
+
+void process_contact(Entity* obj_1, Entity* obj_2, const Contact* contact, double* loss) {
+    if (loss) *loss = 0.0;
+    if (!obj_1 || !obj_2 || !contact || contact->depth <= 0.0 || (obj_1->is_static && obj_2->is_static)) {
+        return;
+    }
+
+    double inv_1 = obj_1->is_static || obj_1->mass <= 0.0 ? 0.0 : 1.0 / obj_1->mass;
+    double inv_2 = obj_2->is_static || obj_2->mass <= 0.0 ? 0.0 : 1.0 / obj_2->mass;
+    double inv_sum = inv_1 + inv_2;
+    if (inv_sum == 0.0) {
+        return;
+    }
+
+    vec3_axpy(&obj_1->position, -contact->depth * inv_1 / inv_sum, contact->normal);
+    vec3_axpy(&obj_2->position, contact->depth * inv_2 / inv_sum, contact->normal);
+
+    apply_restitution_impulse(obj_1, obj_2, &contact->normal, loss);
 }
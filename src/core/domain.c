@@ -0,0 +1,543 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     // sched_setaffinity
+#endif
+#include "../../include/core/domain.h"
+#include "../../include/core/movement.h"
+#include "../../include/core/collider.h"
+#include "../../include/core/time_flow.h"
+#include "../../include/mathlib/vec_math.h"
+#include <stdlib.h>
+#include <string.h>
+
+static double axis_coordinate(const Vector* v, int axis) {
+    return axis == 0 ? v->x : (axis == 1 ? v->y : v->z);
+}
+
+int domain_index_of(const DomainConfig* cfg, const Vector* position) {
+    double width = (cfg->upper - cfg->lower) / cfg->process_count;
+    double idx = floor((axis_coordinate(position, cfg->axis) - cfg->lower) / width);
+    if (idx < 0.0) return 0;
+    if (idx >= cfg->process_count) return cfg->process_count - 1;
+    return (int)idx;
+}
+
+static bool within(const Entity* a, const Entity* b, double distance) {
+    return vec3_length_sq(vec3_sub(a->position, b->position)) < distance * distance;
+}
+
+void domain_default_step(Entity* local, size_t local_count, Entity* ghosts, size_t ghost_count,
+                         double dt, void* user) {
+    const DomainStepParams* params = user;
+    double contact = params ? params->collision_distance : 0.0;
+
+    for (size_t i = 0; i < local_count; i++) {
+        for (size_t j = i + 1; j < local_count; j++) {
+            apply_universal_gravitation(&local[i], &local[j]);
+        }
+        for (size_t g = 0; g < ghost_count; g++) {
+            apply_universal_gravitation(&local[i], &ghosts[g]);
+        }
+    }
+
+    // a ghost pair is resolved by both workers, each keeps only the change to its own body
+    for (size_t i = 0; contact > 0.0 && i < local_count; i++) {
+        for (size_t j = i + 1; j < local_count; j++) {
+            if (within(&local[i], &local[j], contact)) process_collision(&local[i], &local[j], NULL);
+        }
+        for (size_t g = 0; g < ghost_count; g++) {
+            if (within(&local[i], &ghosts[g], contact)) process_collision(&local[i], &ghosts[g], NULL);
+        }
+    }
+
+    for (size_t i = 0; i < local_count; i++) {
+        Entity* e = &local[i];
+        if (!e->is_static) {
+            e->velocity.x += e->acceleration.x * dt;
+            e->velocity.y += e->acceleration.y * dt;
+            e->velocity.z += e->acceleration.z * dt;
+            e->position.x += e->velocity.x * dt;
+            e->position.y += e->velocity.y * dt;
+            e->position.z += e->velocity.z * dt;
+        }
+        e->acceleration.x = 0.0;
+        e->acceleration.y = 0.0;
+        e->acceleration.z = 0.0;
+    }
+}
+
+#ifdef _WIN32
+
+DomainErrorCode domain_run(const DomainConfig* cfg, Entity* entities, size_t* count, size_t capacity,
+                           size_t steps, double dt, DomainStepFn step, void* user, DomainStats* stats) {
+    (void)cfg; (void)entities; (void)count; (void)capacity;
+    (void)steps; (void)dt; (void)step; (void)user; (void)stats;
+    return DOMAIN_ERROR_UNSUPPORTED;
+}
+
+#else
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define DOMAIN_ALIGN 64
+
+enum {
+    RING_GHOST_FROM_LOWER,
+    RING_GHOST_FROM_UPPER,
+    RING_MIGRATE_FROM_LOWER,
+    RING_MIGRATE_FROM_UPPER,
+    RINGS_PER_DOMAIN
+};
+
+/**
+ * Single producer / single consumer ring, the Entity slots follow the header in shared memory.
+ */
+typedef struct DomainRing {
+    _Atomic size_t head;
+    char pad[DOMAIN_ALIGN - sizeof(size_t)];
+    _Atomic size_t tail;
+} DomainRing;
+
+/**
+ * Sense-reversing barrier for the workers, built on atomics since process-shared pthread barriers are not
+ * available everywhere (macOS has no pthread_barrier_t).
+ */
+typedef struct DomainBarrier {
+    atomic_uint arrived;
+    atomic_uint sense;
+    unsigned count;
+} DomainBarrier;
+
+typedef struct DomainShared {
+    DomainBarrier barrier;
+    atomic_int error;
+} DomainShared;
+
+typedef struct DomainSlot {
+    size_t count;
+    DomainStats stats;
+} DomainSlot;
+
+/**
+ * Offsets into the shared segment, identical in every process since the mapping is inherited through fork.
+ */
+typedef struct DomainLayout {
+    unsigned char* base;
+    size_t size;
+    size_t slots_offset;
+    size_t results_offset;
+    size_t rings_offset;
+    size_t ring_stride;
+} DomainLayout;
+
+static size_t align_up(size_t n) {
+    return (n + DOMAIN_ALIGN - 1) / DOMAIN_ALIGN * DOMAIN_ALIGN;
+}
+
+static DomainShared* layout_shared(const DomainLayout* l) {
+    return (DomainShared*)l->base;
+}
+
+static DomainSlot* layout_slot(const DomainLayout* l, int d) {
+    return (DomainSlot*)(l->base + l->slots_offset) + d;
+}
+
+static Entity* layout_results(const DomainLayout* l, const DomainConfig* cfg, int d) {
+    return (Entity*)(l->base + l->results_offset) + (size_t)d * cfg->max_local;
+}
+
+static DomainRing* layout_ring(const DomainLayout* l, int d, int kind) {
+    return (DomainRing*)(l->base + l->rings_offset + ((size_t)d * RINGS_PER_DOMAIN + kind) * l->ring_stride);
+}
+
+static Entity* ring_slots(DomainRing* ring) {
+    return (Entity*)((unsigned char*)ring + align_up(sizeof(DomainRing)));
+}
+
+static bool ring_push(DomainRing* ring, size_t capacity, const Entity* e) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail - head == capacity) {
+        return false;
+    }
+    ring_slots(ring)[tail % capacity] = *e;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+static bool ring_pop(DomainRing* ring, size_t capacity, Entity* out) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+    *out = ring_slots(ring)[head % capacity];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+// the last process to arrive flips the shared sense, the others yield until they see it flipped
+static void barrier_wait(DomainBarrier* b, unsigned* local_sense) {
+    unsigned sense = *local_sense ^ 1u;
+    *local_sense = sense;
+    if (atomic_fetch_add_explicit(&b->arrived, 1, memory_order_acq_rel) + 1 == b->count) {
+        atomic_store_explicit(&b->arrived, 0, memory_order_relaxed);
+        atomic_store_explicit(&b->sense, sense, memory_order_release);
+        return;
+    }
+    while (atomic_load_explicit(&b->sense, memory_order_acquire) != sense) {
+        sched_yield();
+    }
+}
+
+static bool ring_empty(DomainRing* ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) ==
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+#ifdef __linux__
+static int numa_node_count(void) {
+    int nodes = 0;
+    char path[64];
+    for (;;) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", nodes);
+        if (access(path, F_OK) != 0) return nodes;
+        nodes++;
+    }
+}
+
+// cpulist is a comma separated list of ranges such as "0-3,8-11"
+static bool numa_node_cpus(int node, cpu_set_t* set) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+
+    int first, last;
+    while (fscanf(f, "%d", &first) == 1) {
+        last = first;
+        int c = fgetc(f);
+        if (c == '-') {
+            if (fscanf(f, "%d", &last) != 1) break;
+            c = fgetc(f);
+        }
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, set);
+        if (c != ',') break;
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * Pin worker d to the CPUs of NUMA node d mod node count, or without NUMA information to the d-th of
+ * process_count equal groups of the CPUs the process may run on. Best effort, failures leave it unpinned.
+ */
+static void pin_worker(int d, int process_count) {
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int nodes = numa_node_count();
+    if (nodes > 1 && numa_node_cpus(d % nodes, &set)) {
+        CPU_AND(&set, &set, &allowed);
+    }
+
+    if (CPU_COUNT(&set) == 0) {
+        int total = CPU_COUNT(&allowed);
+        if (total == 0) return;
+        int begin, end;
+        if (total >= process_count) {
+            begin = (int)((long)d * total / process_count);
+            end = (int)((long)(d + 1) * total / process_count);
+        } else {
+            begin = d % total;
+            end = begin + 1;
+        }
+        for (int cpu = 0, k = 0; cpu < CPU_SETSIZE && k < end; cpu++) {
+            if (!CPU_ISSET(cpu, &allowed)) continue;
+            if (k >= begin) CPU_SET(cpu, &set);
+            k++;
+        }
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+}
+#endif
+
+static void domain_worker(const DomainLayout* l, const DomainConfig* cfg, int d, size_t steps, double dt,
+                          DomainStepFn step, void* user) {
+    DomainShared* shared = layout_shared(l);
+    DomainSlot* slot = layout_slot(l, d);
+    size_t cap = cfg->ring_capacity;
+    int last = cfg->process_count - 1;
+    double width = (cfg->upper - cfg->lower) / cfg->process_count;
+    double lo = cfg->lower + d * width;
+    double hi = lo + width;
+    unsigned sense = 0;
+    DomainStats st;
+    memset(&st, 0, sizeof(st));
+
+#ifdef __linux__
+    pin_worker(d, cfg->process_count);
+#endif
+#ifdef _OPENMP
+    // the OpenMP thread pool of the parent does not survive fork, keep the step callback single threaded
+    omp_set_num_threads(1);
+#endif
+
+    // allocated after fork so pages are first-touched by this worker
+    Entity* local = malloc(cfg->max_local * sizeof(Entity));
+    Entity* ghosts = malloc(2 * cap * sizeof(Entity));
+    if (!local || !ghosts) {
+        atomic_store(&shared->error, DOMAIN_ERROR_CAPACITY);
+        cap = 0;
+    }
+
+    size_t n = slot->count;
+    if (local) {
+        memcpy(local, layout_results(l, cfg, d), n * sizeof(Entity));
+    }
+
+    for (size_t s = 0; s < steps; s++) {
+        double t0 = wall_clock_ms();
+
+        for (size_t i = 0; cap && i < n; i++) {
+            double x = axis_coordinate(&local[i].position, cfg->axis);
+            if (d > 0 && x < lo + cfg->halo_width) {
+                if (ring_push(layout_ring(l, d - 1, RING_GHOST_FROM_UPPER), cap, &local[i])) st.ghosts_sent++;
+                else st.ghosts_dropped++;
+            }
+            if (d < last && x >= hi - cfg->halo_width) {
+                if (ring_push(layout_ring(l, d + 1, RING_GHOST_FROM_LOWER), cap, &local[i])) st.ghosts_sent++;
+                else st.ghosts_dropped++;
+            }
+        }
+
+        barrier_wait(&shared->barrier, &sense);
+
+        size_t ghost_count = 0;
+        while (cap && ring_pop(layout_ring(l, d, RING_GHOST_FROM_LOWER), cap, &ghosts[ghost_count])) ghost_count++;
+        while (cap && ring_pop(layout_ring(l, d, RING_GHOST_FROM_UPPER), cap, &ghosts[ghost_count])) ghost_count++;
+
+        double t1 = wall_clock_ms();
+        if (local) {
+            step(local, n, ghosts, ghost_count, dt, user);
+        }
+        double t2 = wall_clock_ms();
+
+        for (size_t i = n; cap && i-- > 0;) {
+            int target = domain_index_of(cfg, &local[i].position);
+            if (target == d) continue;
+
+            DomainRing* ring = target < d ? layout_ring(l, d - 1, RING_MIGRATE_FROM_UPPER)
+                                          : layout_ring(l, d + 1, RING_MIGRATE_FROM_LOWER);
+            if (ring_push(ring, cap, &local[i])) {
+                local[i] = local[--n];
+                st.migrated_out++;
+            } else {
+                st.migrations_deferred++;
+            }
+        }
+
+        barrier_wait(&shared->barrier, &sense);
+
+        for (int kind = RING_MIGRATE_FROM_LOWER; cap && kind <= RING_MIGRATE_FROM_UPPER; kind++) {
+            DomainRing* ring = layout_ring(l, d, kind);
+            while (n < cfg->max_local && ring_pop(ring, cap, &local[n])) n++;
+        }
+
+        st.step_ms += t2 - t1;
+        st.exchange_ms += (t1 - t0) + (wall_clock_ms() - t2);
+    }
+
+    if (cap && (!ring_empty(layout_ring(l, d, RING_MIGRATE_FROM_LOWER)) ||
+                !ring_empty(layout_ring(l, d, RING_MIGRATE_FROM_UPPER)))) {
+        atomic_store(&shared->error, DOMAIN_ERROR_CAPACITY);
+    }
+
+    if (local) {
+        memcpy(layout_results(l, cfg, d), local, n * sizeof(Entity));
+    }
+    st.local_count = n;
+    slot->count = n;
+    slot->stats = st;
+
+    free(local);
+    free(ghosts);
+}
+
+static DomainErrorCode layout_create(DomainLayout* l, const DomainConfig* cfg) {
+    static atomic_uint sequence = 0;
+    int p = cfg->process_count;
+
+    l->slots_offset = align_up(sizeof(DomainShared));
+    l->results_offset = l->slots_offset + align_up((size_t)p * sizeof(DomainSlot));
+    l->rings_offset = l->results_offset + align_up((size_t)p * cfg->max_local * sizeof(Entity));
+    l->ring_stride = align_up(align_up(sizeof(DomainRing)) + cfg->ring_capacity * sizeof(Entity));
+    l->size = l->rings_offset + (size_t)p * RINGS_PER_DOMAIN * l->ring_stride;
+
+    char name[64];
+    snprintf(name, sizeof(name), "/cphysics_domain_%ld_%u", (long)getpid(), atomic_fetch_add(&sequence, 1));
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        return DOMAIN_ERROR_SHARED_MEMORY;
+    }
+    // the mapping outlives the name, workers inherit it through fork
+    shm_unlink(name);
+
+    if (ftruncate(fd, (off_t)l->size) != 0) {
+        close(fd);
+        return DOMAIN_ERROR_SHARED_MEMORY;
+    }
+    void* base = mmap(NULL, l->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return DOMAIN_ERROR_SHARED_MEMORY;
+    }
+    l->base = base;
+
+    DomainShared* shared = layout_shared(l);
+    atomic_init(&shared->barrier.arrived, 0);
+    atomic_init(&shared->barrier.sense, 0);
+    shared->barrier.count = (unsigned)p;
+    atomic_init(&shared->error, DOMAIN_SUCCESS);
+
+    for (int d = 0; d < p; d++) {
+        for (int kind = 0; kind < RINGS_PER_DOMAIN; kind++) {
+            DomainRing* ring = layout_ring(l, d, kind);
+            atomic_init(&ring->head, 0);
+            atomic_init(&ring->tail, 0);
+        }
+    }
+
+    return DOMAIN_SUCCESS;
+}
+
+static void layout_destroy(DomainLayout* l) {
+    munmap(l->base, l->size);
+}
+
+static void kill_workers(const pid_t* workers, int started) {
+    for (int k = 0; k < started; k++) {
+        if (workers[k] > 0) kill(workers[k], SIGKILL);
+    }
+}
+
+DomainErrorCode domain_run(const DomainConfig* cfg, Entity* entities, size_t* count, size_t capacity,
+                           size_t steps, double dt, DomainStepFn step, void* user, DomainStats* stats) {
+    if (!cfg || !entities || !count) {
+        return DOMAIN_ERROR_NULL_POINTER;
+    }
+    if (cfg->process_count < 1 || cfg->axis < 0 || cfg->axis > 2 || !(cfg->upper > cfg->lower) ||
+        cfg->halo_width < 0.0 || cfg->max_local == 0 || cfg->ring_capacity == 0 || *count > capacity) {
+        return DOMAIN_ERROR_INVALID_CONFIG;
+    }
+    if (!step) {
+        step = domain_default_step;
+    }
+
+    DomainLayout l;
+    DomainErrorCode err = layout_create(&l, cfg);
+    if (err != DOMAIN_SUCCESS) {
+        return err;
+    }
+
+    for (int d = 0; d < cfg->process_count; d++) {
+        layout_slot(&l, d)->count = 0;
+    }
+    for (size_t i = 0; i < *count; i++) {
+        int d = domain_index_of(cfg, &entities[i].position);
+        DomainSlot* slot = layout_slot(&l, d);
+        if (slot->count == cfg->max_local) {
+            layout_destroy(&l);
+            return DOMAIN_ERROR_CAPACITY;
+        }
+        layout_results(&l, cfg, d)[slot->count++] = entities[i];
+    }
+
+    pid_t* workers = malloc((size_t)cfg->process_count * sizeof(pid_t));
+    if (!workers) {
+        layout_destroy(&l);
+        return DOMAIN_ERROR_CAPACITY;
+    }
+
+    fflush(NULL);
+    int started = 0;
+    for (; started < cfg->process_count; started++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            domain_worker(&l, cfg, started, steps, dt, step, user);
+            _exit(0);
+        }
+        if (pid < 0) {
+            // the barrier can never complete, stop the workers already waiting on it
+            kill_workers(workers, started);
+            err = DOMAIN_ERROR_PROCESS;
+            break;
+        }
+        workers[started] = pid;
+    }
+
+    // poll only our own workers, a worker that dies leaves its siblings waiting at the barrier so they are killed
+    const struct timespec poll_interval = {0, 1000000};
+    for (int running = started; running > 0;) {
+        bool reaped = false;
+        for (int k = 0; k < started; k++) {
+            if (workers[k] <= 0) continue;
+
+            int status;
+            pid_t pid = waitpid(workers[k], &status, WNOHANG);
+            if (pid == 0 || (pid < 0 && errno == EINTR)) continue;
+
+            workers[k] = 0;
+            running--;
+            reaped = true;
+            if ((pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) && err == DOMAIN_SUCCESS) {
+                err = DOMAIN_ERROR_PROCESS;
+                kill_workers(workers, started);
+            }
+        }
+        if (!reaped && running > 0) nanosleep(&poll_interval, NULL);
+    }
+    free(workers);
+
+    if (err == DOMAIN_SUCCESS) {
+        err = (DomainErrorCode)atomic_load(&layout_shared(&l)->error);
+    }
+
+    if (err == DOMAIN_SUCCESS) {
+        size_t total = 0;
+        for (int d = 0; d < cfg->process_count; d++) {
+            total += layout_slot(&l, d)->count;
+        }
+        if (total > capacity) {
+            err = DOMAIN_ERROR_CAPACITY;
+        } else {
+            size_t n = 0;
+            for (int d = 0; d < cfg->process_count; d++) {
+                DomainSlot* slot = layout_slot(&l, d);
+                memcpy(entities + n, layout_results(&l, cfg, d), slot->count * sizeof(Entity));
+                n += slot->count;
+                if (stats) stats[d] = slot->stats;
+            }
+            *count = n;
+        }
+    }
+
+    layout_destroy(&l);
+    return err;
+}
+
+#endif
@@ -0,0 +1,336 @@
+#include "../../include/core/ensemble.h"
+#include <stdlib.h>
+
+#define BODY_ARRAYS 13
+#define WORLD_ARRAYS 11
+
+static double** body_arrays(Ensemble* ens, double** out) {
+    double* arrays[BODY_ARRAYS] = {
+        ens->px, ens->py, ens->pz, ens->vx, ens->vy, ens->vz, ens->ax, ens->ay, ens->az,
+        ens->mass, ens->inv_mass, ens->charge, ens->radius
+    };
+    memcpy(out, arrays, sizeof(arrays));
+    return out;
+}
+
+static double** world_arrays(Ensemble* ens, double** out) {
+    double* arrays[WORLD_ARRAYS] = {
+        ens->dt, ens->restitution, ens->gravity_constant, ens->gx, ens->gy, ens->gz,
+        ens->ex, ens->ey, ens->ez, ens->time, ens->t_end
+    };
+    memcpy(out, arrays, sizeof(arrays));
+    return out;
+}
+
+ErrorCode ensemble_init(Ensemble* ens, size_t worlds, size_t slots) {
+    if (!ens || worlds == 0 || slots == 0) {
+        return OPERATION_SET_FAILED;
+    }
+    memset(ens, 0, sizeof(*ens));
+
+    size_t cap = (worlds + ENSEMBLE_BLOCK - 1) / ENSEMBLE_BLOCK * ENSEMBLE_BLOCK;
+    size_t body_len = slots * cap;
+    ens->storage = calloc(BODY_ARRAYS * body_len + WORLD_ARRAYS * cap, sizeof(double));
+    ens->retired = calloc(cap, 1);
+    ens->world_id = malloc(cap * sizeof(size_t));
+    if (!ens->storage || !ens->retired || !ens->world_id) {
+        ensemble_free(ens);
+        return OPERATION_SET_FAILED;
+    }
+
+    ens->world_count = worlds;
+    ens->world_capacity = cap;
+    ens->slot_count = slots;
+
+    double** body[BODY_ARRAYS] = {
+        &ens->px, &ens->py, &ens->pz, &ens->vx, &ens->vy, &ens->vz, &ens->ax, &ens->ay, &ens->az,
+        &ens->mass, &ens->inv_mass, &ens->charge, &ens->radius
+    };
+    double** world[WORLD_ARRAYS] = {
+        &ens->dt, &ens->restitution, &ens->gravity_constant, &ens->gx, &ens->gy, &ens->gz,
+        &ens->ex, &ens->ey, &ens->ez, &ens->time, &ens->t_end
+    };
+    double* p = ens->storage;
+    for (int a = 0; a < BODY_ARRAYS; a++, p += body_len) *body[a] = p;
+    for (int a = 0; a < WORLD_ARRAYS; a++, p += cap) *world[a] = p;
+
+    for (size_t w = 0; w < cap; w++) {
+        ens->restitution[w] = 1.0;
+        ens->gravity_constant[w] = G;
+        ens->t_end[w] = INFINITY;
+        ens->world_id[w] = w;
+        ens->retired[w] = w >= worlds;
+    }
+
+    return OPERATION_SET_SUCCESS;
+}
+
+void ensemble_free(Ensemble* ens) {
+    if (!ens) return;
+    free(ens->storage);
+    free(ens->retired);
+    free(ens->world_id);
+    memset(ens, 0, sizeof(*ens));
+}
+
+ErrorCode ensemble_set_body(Ensemble* ens, size_t lane, size_t slot, const Entity* e, double radius) {
+    if (!ens || !e) {
+        return ENTITY_VOID_ERROR;
+    }
+    if (lane >= ens->world_count || slot >= ens->slot_count) {
+        return OPERATION_SET_FAILED;
+    }
+
+    size_t i = slot * ens->world_capacity + lane;
+    ens->px[i] = e->position.x;
+    ens->py[i] = e->position.y;
+    ens->pz[i] = e->position.z;
+    ens->vx[i] = e->velocity.x;
+    ens->vy[i] = e->velocity.y;
+    ens->vz[i] = e->velocity.z;
+    ens->mass[i] = e->mass;
+    ens->inv_mass[i] = (e->is_static || e->mass <= 0.0) ? 0.0 : 1.0 / e->mass;
+    ens->charge[i] = e->charge;
+    ens->radius[i] = radius;
+
+    return OPERATION_SET_SUCCESS;
+}
+
+ErrorCode ensemble_get_body(const Ensemble* ens, size_t lane, size_t slot, Entity* out) {
+    if (!ens || !out) {
+        return ENTITY_VOID_ERROR;
+    }
+    if (lane >= ens->world_count || slot >= ens->slot_count) {
+        return OPERATION_GET_FAILED;
+    }
+
+    size_t i = slot * ens->world_capacity + lane;
+    Vector pos = {ens->px[i], ens->py[i], ens->pz[i]};
+    Vector vel = {ens->vx[i], ens->vy[i], ens->vz[i]};
+    Vector acc = {ens->ax[i], ens->ay[i], ens->az[i]};
+    *out = new_entity("", ens->mass[i], ens->charge[i], &pos, &vel, &acc,
+                      ens->restitution[lane], true, ens->inv_mass[i] == 0.0);
+
+    return OPERATION_GET_SUCCESS;
+}
+
+ErrorCode ensemble_set_world(Ensemble* ens, size_t lane, double dt, double restitution,
+                             const Vector* gravity_field, const Vector* electric_field) {
+    if (!ens) {
+        return ENTITY_VOID_ERROR;
+    }
+    if (lane >= ens->world_count) {
+        return OPERATION_SET_FAILED;
+    }
+
+    ens->dt[lane] = dt;
+    ens->restitution[lane] = restitution;
+    ens->gx[lane] = gravity_field ? gravity_field->x : 0.0;
+    ens->gy[lane] = gravity_field ? gravity_field->y : 0.0;
+    ens->gz[lane] = gravity_field ? gravity_field->z : 0.0;
+    ens->ex[lane] = electric_field ? electric_field->x : 0.0;
+    ens->ey[lane] = electric_field ? electric_field->y : 0.0;
+    ens->ez[lane] = electric_field ? electric_field->z : 0.0;
+
+    return OPERATION_SET_SUCCESS;
+}
+
+void ensemble_retire(Ensemble* ens, size_t lane) {
+    if (ens && lane < ens->world_count) {
+        ens->retired[lane] = 1;
+    }
+}
+
+/**
+ * One step of the worlds in lanes [w0, w0 + ENSEMBLE_BLOCK). Every loop over w is branch free so it
+ * vectorises; retired and padding lanes are computed too but frozen through a zero dt.
+ */
+static void step_block(Ensemble* e, size_t w0) {
+    const size_t cap = e->world_capacity;
+    const size_t slots = e->slot_count;
+    const size_t w1 = w0 + ENSEMBLE_BLOCK;
+
+    // local restrict copies so the compiler knows the stores cannot alias the Ensemble itself
+    double* restrict px = e->px; double* restrict py = e->py; double* restrict pz = e->pz;
+    double* restrict vx = e->vx; double* restrict vy = e->vy; double* restrict vz = e->vz;
+    double* restrict ax = e->ax; double* restrict ay = e->ay; double* restrict az = e->az;
+    const double* restrict mass = e->mass;
+    const double* restrict inv_mass = e->inv_mass;
+    const double* restrict charge = e->charge;
+    const double* restrict radius = e->radius;
+    const double* restrict dt_world = e->dt;
+    const double* restrict restitution = e->restitution;
+    const double* restrict gravity_constant = e->gravity_constant;
+    const double* restrict gx = e->gx; const double* restrict gy = e->gy; const double* restrict gz = e->gz;
+    const double* restrict ex = e->ex; const double* restrict ey = e->ey; const double* restrict ez = e->ez;
+    double* restrict time = e->time;
+    const double* restrict t_end = e->t_end;
+    unsigned char* restrict retired = e->retired;
+
+    for (size_t s = 0; s < slots; s++) {
+        size_t b = s * cap;
+        #pragma omp simd
+        for (size_t w = w0; w < w1; w++) {
+            double movable = inv_mass[b + w] > 0.0 ? 1.0 : 0.0;
+            double qm = charge[b + w] * inv_mass[b + w];
+            ax[b + w] = movable * gx[w] + qm * ex[w];
+            ay[b + w] = movable * gy[w] + qm * ey[w];
+            az[b + w] = movable * gz[w] + qm * ez[w];
+        }
+    }
+
+    for (size_t s = 0; s < slots; s++) {
+        for (size_t t = s + 1; t < slots; t++) {
+            size_t i = s * cap, j = t * cap;
+            #pragma omp simd
+            for (size_t w = w0; w < w1; w++) {
+                double dx = px[i + w] - px[j + w];
+                double dy = py[i + w] - py[j + w];
+                double dz = pz[i + w] - pz[j + w];
+                double r2 = dx*dx + dy*dy + dz*dz;
+                r2 = r2 > 0.0 ? r2 : 1.0;   // only unused slots coincide, their force is zero anyway
+                double inv_r = 1.0 / sqrt(r2);
+                double inv_r3 = inv_r * inv_r * inv_r;
+                // positive pushes the bodies apart
+                double f = (K * charge[i + w] * charge[j + w]
+                            - gravity_constant[w] * mass[i + w] * mass[j + w]) * inv_r3;
+                double fi = f * inv_mass[i + w];
+                double fj = f * inv_mass[j + w];
+                ax[i + w] += fi * dx;
+                ay[i + w] += fi * dy;
+                az[i + w] += fi * dz;
+                ax[j + w] -= fj * dx;
+                ay[j + w] -= fj * dy;
+                az[j + w] -= fj * dz;
+            }
+        }
+    }
+
+    for (size_t s = 0; s < slots; s++) {
+        size_t b = s * cap;
+        #pragma omp simd
+        for (size_t w = w0; w < w1; w++) {
+            double dt = dt_world[w] * (double)(1 - retired[w]);
+            vx[b + w] += ax[b + w] * dt;
+            vy[b + w] += ay[b + w] * dt;
+            vz[b + w] += az[b + w] * dt;
+            px[b + w] += vx[b + w] * dt;
+            py[b + w] += vy[b + w] * dt;
+            pz[b + w] += vz[b + w] * dt;
+        }
+    }
+
+    // restitution impulse along the line of centres, same as process_collision
+    for (size_t s = 0; s < slots; s++) {
+        for (size_t t = s + 1; t < slots; t++) {
+            size_t i = s * cap, j = t * cap;
+            #pragma omp simd
+            for (size_t w = w0; w < w1; w++) {
+                double dx = px[j + w] - px[i + w];
+                double dy = py[j + w] - py[i + w];
+                double dz = pz[j + w] - pz[i + w];
+                double dist2 = dx*dx + dy*dy + dz*dz;
+                double rsum = radius[i + w] + radius[j + w];
+                double dist = sqrt(dist2);
+                double inv_dist = dist > 0.0 ? 1.0 / dist : 0.0;
+                double nx = dx * inv_dist, ny = dy * inv_dist, nz = dz * inv_dist;
+                double v_rel = (vx[j + w] - vx[i + w]) * nx +
+                               (vy[j + w] - vy[i + w]) * ny +
+                               (vz[j + w] - vz[i + w]) * nz;
+                double inv_sum = inv_mass[i + w] + inv_mass[j + w];
+                // unused slots (and point bodies) have radius 0, they must not act as walls at their position
+                double sized = (double)(radius[i + w] > 0.0) * (radius[j + w] > 0.0);
+                double hit = (double)(1 - retired[w]) * sized * (dist2 < rsum * rsum) * (v_rel < 0.0) *
+                             (inv_sum > 0.0);
+                double impulse = hit * -(1.0 + restitution[w]) * v_rel / (inv_sum > 0.0 ? inv_sum : 1.0);
+                double push = hit * (rsum - dist) / (inv_sum > 0.0 ? inv_sum : 1.0);
+
+                double ci = impulse * inv_mass[i + w], cj = impulse * inv_mass[j + w];
+                vx[i + w] -= ci * nx;
+                vy[i + w] -= ci * ny;
+                vz[i + w] -= ci * nz;
+                vx[j + w] += cj * nx;
+                vy[j + w] += cj * ny;
+                vz[j + w] += cj * nz;
+
+                double pi = push * inv_mass[i + w], pj = push * inv_mass[j + w];
+                px[i + w] -= pi * nx;
+                py[i + w] -= pi * ny;
+                pz[i + w] -= pi * nz;
+                px[j + w] += pj * nx;
+                py[j + w] += pj * ny;
+                pz[j + w] += pj * nz;
+            }
+        }
+    }
+
+    for (size_t w = w0; w < w1; w++) {
+        if (retired[w]) continue;
+        time[w] += dt_world[w];
+        if (time[w] >= t_end[w]) retired[w] = 1;
+    }
+}
+
+ErrorCode ensemble_step(Ensemble* ens, size_t steps) {
+    if (!ens || !ens->storage) {
+        return OPERATION_SET_FAILED;
+    }
+
+    // blocks are independent, each runs all its steps while its worlds stay in cache
+    long blocks = (long)((ens->world_count + ENSEMBLE_BLOCK - 1) / ENSEMBLE_BLOCK);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long b = 0; b < blocks; b++) {
+        for (size_t s = 0; s < steps; s++) {
+            step_block(ens, (size_t)b * ENSEMBLE_BLOCK);
+        }
+    }
+
+    return OPERATION_SET_SUCCESS;
+}
+
+size_t ensemble_compact(Ensemble* ens, EnsembleRetireFn on_retire, void* user) {
+    if (!ens || !ens->storage) {
+        return 0;
+    }
+
+    double* body[BODY_ARRAYS];
+    double* world[WORLD_ARRAYS];
+    body_arrays(ens, body);
+    world_arrays(ens, world);
+    size_t cap = ens->world_capacity;
+
+    size_t live = 0;
+    for (size_t w = 0; w < ens->world_count; w++) {
+        if (ens->retired[w]) {
+            if (on_retire) on_retire(ens, w, user);
+            continue;
+        }
+        if (live != w) {
+            for (int a = 0; a < BODY_ARRAYS; a++) {
+                for (size_t s = 0; s < ens->slot_count; s++) {
+                    body[a][s * cap + live] = body[a][s * cap + w];
+                }
+            }
+            for (int a = 0; a < WORLD_ARRAYS; a++) {
+                world[a][live] = world[a][w];
+            }
+            ens->world_id[live] = ens->world_id[w];
+            ens->retired[live] = 0;
+        }
+        live++;
+    }
+
+    // vacated lanes become inert padding
+    for (size_t w = live; w < ens->world_count; w++) {
+        for (int a = 0; a < BODY_ARRAYS; a++) {
+            for (size_t s = 0; s < ens->slot_count; s++) {
+                body[a][s * cap + w] = 0.0;
+            }
+        }
+        ens->dt[w] = 0.0;
+        ens->retired[w] = 1;
+    }
+
+    ens->world_count = live;
+    return live;
+}
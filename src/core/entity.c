@@ -2,14 +2,19 @@
 #include "../../include/plog.h"
 #include <string.h>
 #include <math.h>
+#include "../../include/mathlib/vec_math.h"
 
 struct Entity new_entity(const char* n, double m, double c,
                                    const Vector* d, const Vector* v,
                                    const Vector* a, double cor, bool rigid, bool s){
     struct Entity obj;
 
-    strncpy(obj.name, n, 255);
-    obj.name[255] = '\0';
+    // interning failures leave the entity unnamed rather than failing the constructor
+    obj.name_id = NAME_ID_NONE;
+    NameRegistry* names = name_registry_default();
+    if (names && n) {
+        name_registry_intern(names, n, &obj.name_id);
+    }
 
     obj.mass = m;
     obj.charge = c;
@@ -59,26 +64,36 @@ struct Entity new_entity(const char* n, double m, double c,
 
 
 
+const char* entity_name(const Entity* obj) {
+    if (!obj) return "";
+    return name_registry_str(name_registry_default(), obj->name_id);
+}
+
+ErrorCode set_entity_name(Entity* obj, const char* name) {
+    if (obj == NULL) {
+        return OPERATION_SET_FAILED;
+    }
+    NameId id;
+    if (name_registry_intern(name_registry_default(), name, &id) != NAME_REGISTRY_SUCCESS) {
+        return OPERATION_SET_FAILED;
+    }
+    obj->name_id = id;
+
+    return OPERATION_SET_SUCCESS;
+}
+
 Vector* get_position(Entity* obj) {return &obj->position;}
 Vector* get_acceleration(Entity* obj) {return &obj->acceleration;}
 Vector* get_velocity(Entity* obj) {return &obj->velocity;}
 
 
 double get_euclidean_distance(const Entity* obj_1, const Entity* obj_2) {
-    double dx = obj_1->position.x - obj_2->position.x,
-           dy = obj_1->position.y - obj_2->position.y,
-           dz = obj_1->position.z - obj_2->position.z;
-
-    double euclidean_distance_squared = dx*dx + dy*dy + dz*dz;
-
-    return sqrt(euclidean_distance_squared);
+    return vec3_distance(obj_1->position, obj_2->position);
 }
 
 void get_linear_momentum(const Entity* obj, Vector* result) {
     if (obj && result) {
-        result->x = obj->mass * obj->velocity.x;
-        result->y = obj->mass * obj->velocity.y;
-        result->z = obj->mass * obj->velocity.z;
+        *result = vec3_scale(obj->velocity, obj->mass);
     }
 }
 
@@ -1,14 +1,13 @@
 #include "../../include/core/field.h"
 #include <math.h>
 #include <float.h>
+#include "../../include/mathlib/vec_math.h"
 
 FieldErrorCode apply_gravitational_field(Entity* obj, const gravitational_field* g) {
     if (obj == NULL || g == NULL) return FIELD_ERROR_NULL_POINTER;
     if (obj->is_static) return FIELD_ERROR_STATIC_OBJECT;
     
-    obj->acceleration.x += g->magnitude * g->direction.x;
-    obj->acceleration.y += g->magnitude * g->direction.y;
-    obj->acceleration.z += g->magnitude * g->direction.z;
+    vec3_axpy(&obj->acceleration, g->magnitude, g->direction);
     
     return FIELD_SUCCESS;
 }
@@ -19,9 +18,7 @@ FieldErrorCode apply_electric_field(Entity* obj, const electric_field* e) {
     if (obj->mass < DBL_EPSILON) return FIELD_ERROR_INVALID_MASS;
     
     double force_magnitude = obj->charge * e->magnitude;
-    obj->acceleration.x += (force_magnitude / obj->mass) * e->direction.x;
-    obj->acceleration.y += (force_magnitude / obj->mass) * e->direction.y;
-    obj->acceleration.z += (force_magnitude / obj->mass) * e->direction.z;
+    vec3_axpy(&obj->acceleration, force_magnitude / obj->mass, e->direction);
     
     return FIELD_SUCCESS;
 }
@@ -32,12 +29,10 @@ FieldErrorCode apply_magnetic_field(Entity* obj, const magnetic_field* b) {
     if (obj->mass < DBL_EPSILON) return FIELD_ERROR_INVALID_MASS;
     if (fabs(obj->charge) < DBL_EPSILON) return FIELD_ERROR_INVALID_CHARGE;
     
-    Vector cross_result = cross_product(obj->velocity, b->direction);
+    Vector cross_result = vec3_cross(obj->velocity, b->direction);
     
     double force_factor = (obj->charge * b->magnitude) / obj->mass;
-    obj->acceleration.x += force_factor * cross_result.x;
-    obj->acceleration.y += force_factor * cross_result.y;
-    obj->acceleration.z += force_factor * cross_result.z;
+    vec3_axpy(&obj->acceleration, force_factor, cross_result);
     
     return FIELD_SUCCESS;
 }
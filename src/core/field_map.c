@@ -0,0 +1,371 @@
+#include "../../include/core/field_map.h"
+#include "../../include/mathlib/vec_math.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <float.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define FIELD_MAP_PARALLEL_THRESHOLD 4096
+#define BRICK_POINTS (FIELD_MAP_BRICK * FIELD_MAP_BRICK * FIELD_MAP_BRICK)
+
+static const char FIELD_MAP_MAGIC[8] = {'C', 'P', 'F', 'I', 'E', 'L', 'D', '1'};
+static const uint64_t FIELD_MAP_BYTE_ORDER = 0x0102030405060708ULL;
+
+/**
+ * File header, every member is naturally aligned so the struct has no padding. Data starts at data_offset.
+ */
+typedef struct FieldMapHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t nx, ny, nz;
+    uint32_t brick;
+    double origin[3];
+    double spacing[3];
+    uint64_t data_offset;
+    uint64_t byte_order;
+    uint8_t reserved[32];
+} FieldMapHeader;
+
+#define FIELD_MAP_HEADER_SIZE 128
+
+typedef char field_map_header_size_check[sizeof(FieldMapHeader) == FIELD_MAP_HEADER_SIZE ? 1 : -1];
+
+// spreads the 2 bits of a brick local coordinate 3 apart
+static const unsigned char morton_lut[FIELD_MAP_BRICK] = {0, 1, 8, 9};
+
+static inline size_t point_index(const FieldMap* map, size_t i, size_t j, size_t k) {
+    size_t brick = ((k / FIELD_MAP_BRICK) * map->by + (j / FIELD_MAP_BRICK)) * map->bx + (i / FIELD_MAP_BRICK);
+    size_t local = morton_lut[i % FIELD_MAP_BRICK] |
+                   morton_lut[j % FIELD_MAP_BRICK] << 1 |
+                   morton_lut[k % FIELD_MAP_BRICK] << 2;
+    return 3 * (brick * BRICK_POINTS + local);
+}
+
+static size_t map_doubles(const FieldMap* map) {
+    return 3 * map->bx * map->by * map->bz * BRICK_POINTS;
+}
+
+// whether map_doubles(map) <= limit, dividing instead of multiplying so large dimensions cannot wrap
+static bool map_fits(const FieldMap* map, size_t limit) {
+    return map->bz <= limit / (3 * BRICK_POINTS) / map->bx / map->by;
+}
+
+static bool valid_geometry(size_t nx, size_t ny, size_t nz, const Vector* spacing) {
+    return nx > 0 && ny > 0 && nz > 0 && spacing->x > 0.0 && spacing->y > 0.0 && spacing->z > 0.0;
+}
+
+static void set_geometry(FieldMap* map, FieldMapKind kind, size_t nx, size_t ny, size_t nz,
+                         const Vector* origin, const Vector* spacing) {
+    map->kind = kind;
+    map->nx = nx;
+    map->ny = ny;
+    map->nz = nz;
+    map->bx = nx / FIELD_MAP_BRICK + (nx % FIELD_MAP_BRICK != 0);
+    map->by = ny / FIELD_MAP_BRICK + (ny % FIELD_MAP_BRICK != 0);
+    map->bz = nz / FIELD_MAP_BRICK + (nz % FIELD_MAP_BRICK != 0);
+    map->origin = *origin;
+    map->spacing = *spacing;
+    map->inv_spacing = vec3(1.0 / spacing->x, 1.0 / spacing->y, 1.0 / spacing->z);
+}
+
+FieldErrorCode field_map_create(FieldMap* map, FieldMapKind kind, size_t nx, size_t ny, size_t nz,
+                                const Vector* origin, const Vector* spacing) {
+    if (!map || !origin || !spacing) return FIELD_ERROR_NULL_POINTER;
+    memset(map, 0, sizeof(*map));
+    if (!valid_geometry(nx, ny, nz, spacing)) return FIELD_ERROR_INVALID_MAP;
+
+    set_geometry(map, kind, nx, ny, nz, origin, spacing);
+    if (!map_fits(map, SIZE_MAX / sizeof(double))) return FIELD_ERROR_INVALID_MAP;
+    map->owned = calloc(map_doubles(map), sizeof(double));
+    if (!map->owned) return FIELD_ERROR_OUT_OF_MEMORY;
+    map->data = map->owned;
+    return FIELD_SUCCESS;
+}
+
+void field_map_free(FieldMap* map) {
+    if (!map) return;
+#ifndef _WIN32
+    if (map->mapping) munmap(map->mapping, map->mapping_size);
+#else
+    free(map->mapping);
+#endif
+    free(map->owned);
+    memset(map, 0, sizeof(*map));
+}
+
+FieldErrorCode field_map_set(FieldMap* map, size_t i, size_t j, size_t k, const Vector* value) {
+    if (!map || !value) return FIELD_ERROR_NULL_POINTER;
+    if (!map->owned || i >= map->nx || j >= map->ny || k >= map->nz) return FIELD_ERROR_INVALID_MAP;
+    double* p = map->owned + point_index(map, i, j, k);
+    p[0] = value->x;
+    p[1] = value->y;
+    p[2] = value->z;
+    return FIELD_SUCCESS;
+}
+
+FieldErrorCode field_map_get(const FieldMap* map, size_t i, size_t j, size_t k, Vector* value) {
+    if (!map || !value) return FIELD_ERROR_NULL_POINTER;
+    if (!map->data || i >= map->nx || j >= map->ny || k >= map->nz) return FIELD_ERROR_INVALID_MAP;
+    const double* p = map->data + point_index(map, i, j, k);
+    *value = vec3(p[0], p[1], p[2]);
+    return FIELD_SUCCESS;
+}
+
+FieldErrorCode field_map_save(const FieldMap* map, const char* path) {
+    if (!map || !path) return FIELD_ERROR_NULL_POINTER;
+    if (!map->data) return FIELD_ERROR_INVALID_MAP;
+    if (map->nx > UINT32_MAX || map->ny > UINT32_MAX || map->nz > UINT32_MAX) return FIELD_ERROR_FORMAT;
+
+    FieldMapHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, FIELD_MAP_MAGIC, sizeof(h.magic));
+    h.version = 1;
+    h.kind = (uint32_t)map->kind;
+    h.nx = (uint32_t)map->nx;
+    h.ny = (uint32_t)map->ny;
+    h.nz = (uint32_t)map->nz;
+    h.brick = FIELD_MAP_BRICK;
+    h.origin[0] = map->origin.x;
+    h.origin[1] = map->origin.y;
+    h.origin[2] = map->origin.z;
+    h.spacing[0] = map->spacing.x;
+    h.spacing[1] = map->spacing.y;
+    h.spacing[2] = map->spacing.z;
+    h.data_offset = FIELD_MAP_HEADER_SIZE;
+    h.byte_order = FIELD_MAP_BYTE_ORDER;
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return FIELD_ERROR_IO;
+    size_t n = map_doubles(map);
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(map->data, sizeof(double), n, f) == n;
+    ok = fclose(f) == 0 && ok;
+    return ok ? FIELD_SUCCESS : FIELD_ERROR_IO;
+}
+
+static FieldErrorCode map_file(const char* path, void** data, size_t* size) {
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return FIELD_ERROR_IO;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return FIELD_ERROR_IO;
+    }
+    if ((size_t)st.st_size < FIELD_MAP_HEADER_SIZE) {
+        close(fd);
+        return FIELD_ERROR_FORMAT;
+    }
+    *size = (size_t)st.st_size;
+    // shared read-only mapping: processes loading the same map share its pages
+    void* p = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return FIELD_ERROR_IO;
+    *data = p;
+    return FIELD_SUCCESS;
+#else
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return FIELD_ERROR_IO;
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (len < FIELD_MAP_HEADER_SIZE) {
+        fclose(fp);
+        return len < 0 ? FIELD_ERROR_IO : FIELD_ERROR_FORMAT;
+    }
+    void* buf = malloc((size_t)len);
+    if (!buf) {
+        fclose(fp);
+        return FIELD_ERROR_OUT_OF_MEMORY;
+    }
+    *size = fread(buf, 1, (size_t)len, fp);
+    fclose(fp);
+    *data = buf;
+    return FIELD_SUCCESS;
+#endif
+}
+
+FieldErrorCode field_map_load(FieldMap* map, const char* path) {
+    if (!map || !path) return FIELD_ERROR_NULL_POINTER;
+    memset(map, 0, sizeof(*map));
+
+    void* data;
+    size_t size;
+    FieldErrorCode err = map_file(path, &data, &size);
+    if (err != FIELD_SUCCESS) return err;
+    map->mapping = data;
+    map->mapping_size = size;
+
+    FieldMapHeader h;
+    memcpy(&h, data, sizeof(h));
+    Vector origin = vec3(h.origin[0], h.origin[1], h.origin[2]);
+    Vector spacing = vec3(h.spacing[0], h.spacing[1], h.spacing[2]);
+    bool ok = memcmp(h.magic, FIELD_MAP_MAGIC, sizeof(h.magic)) == 0 &&
+              h.version == 1 &&
+              h.byte_order == FIELD_MAP_BYTE_ORDER &&
+              h.brick == FIELD_MAP_BRICK &&
+              h.kind <= FIELD_MAP_MAGNETIC &&
+              h.data_offset >= FIELD_MAP_HEADER_SIZE && h.data_offset % sizeof(double) == 0 &&
+              valid_geometry(h.nx, h.ny, h.nz, &spacing);
+    if (ok) {
+        set_geometry(map, (FieldMapKind)h.kind, h.nx, h.ny, h.nz, &origin, &spacing);
+        ok = h.data_offset <= size && map_fits(map, (size - h.data_offset) / sizeof(double));
+    }
+    if (!ok) {
+        field_map_free(map);
+        return FIELD_ERROR_FORMAT;
+    }
+    map->data = (const double*)((const char*)data + h.data_offset);
+    return FIELD_SUCCESS;
+}
+
+/**
+ * Grid coordinate of a position along one axis, split into a cell index and the offset inside the cell.
+ * Positions outside the grid are clamped to its boundary.
+ */
+static inline size_t grid_cell(double x, double origin, double inv_spacing, size_t n, double* t) {
+    double g = (x - origin) * inv_spacing;
+    double last = (double)(n - 1);
+    g = g >= 0.0 ? g : 0.0;     // also maps NaN to the first cell
+    g = g > last ? last : g;
+    size_t i = (size_t)g;
+    if (i + 1 >= n) {
+        i = n > 1 ? n - 2 : 0;
+    }
+    *t = n > 1 ? g - (double)i : 0.0;
+    return i;
+}
+
+static inline size_t clamp_index(long i, size_t n) {
+    return i < 0 ? 0 : (size_t)i >= n ? n - 1 : (size_t)i;
+}
+
+static inline Vector sample_trilinear(const FieldMap* map, const Vector* p) {
+    double tx, ty, tz;
+    size_t i = grid_cell(p->x, map->origin.x, map->inv_spacing.x, map->nx, &tx);
+    size_t j = grid_cell(p->y, map->origin.y, map->inv_spacing.y, map->ny, &ty);
+    size_t k = grid_cell(p->z, map->origin.z, map->inv_spacing.z, map->nz, &tz);
+    size_t i1 = i + (map->nx > 1), j1 = j + (map->ny > 1), k1 = k + (map->nz > 1);
+
+    const size_t corner[8] = {
+        point_index(map, i, j, k),   point_index(map, i1, j, k),
+        point_index(map, i, j1, k),  point_index(map, i1, j1, k),
+        point_index(map, i, j, k1),  point_index(map, i1, j, k1),
+        point_index(map, i, j1, k1), point_index(map, i1, j1, k1)
+    };
+    const double w[8] = {
+        (1 - tx) * (1 - ty) * (1 - tz), tx * (1 - ty) * (1 - tz),
+        (1 - tx) * ty * (1 - tz),       tx * ty * (1 - tz),
+        (1 - tx) * (1 - ty) * tz,       tx * (1 - ty) * tz,
+        (1 - tx) * ty * tz,             tx * ty * tz
+    };
+
+    double v[3] = {0.0, 0.0, 0.0};
+    for (int c = 0; c < 8; c++) {
+        const double* d = map->data + corner[c];
+        v[0] += w[c] * d[0];
+        v[1] += w[c] * d[1];
+        v[2] += w[c] * d[2];
+    }
+    return vec3(v[0], v[1], v[2]);
+}
+
+static inline void catmull_rom_weights(double t, double w[4]) {
+    double t2 = t * t, t3 = t2 * t;
+    w[0] = -0.5 * t3 + t2 - 0.5 * t;
+    w[1] = 1.5 * t3 - 2.5 * t2 + 1.0;
+    w[2] = -1.5 * t3 + 2.0 * t2 + 0.5 * t;
+    w[3] = 0.5 * t3 - 0.5 * t2;
+}
+
+static inline Vector sample_tricubic(const FieldMap* map, const Vector* p) {
+    double tx, ty, tz;
+    size_t i = grid_cell(p->x, map->origin.x, map->inv_spacing.x, map->nx, &tx);
+    size_t j = grid_cell(p->y, map->origin.y, map->inv_spacing.y, map->ny, &ty);
+    size_t k = grid_cell(p->z, map->origin.z, map->inv_spacing.z, map->nz, &tz);
+
+    double wx[4], wy[4], wz[4];
+    catmull_rom_weights(tx, wx);
+    catmull_rom_weights(ty, wy);
+    catmull_rom_weights(tz, wz);
+    size_t ix[4], iy[4], iz[4];
+    for (int a = 0; a < 4; a++) {
+        ix[a] = clamp_index((long)i + a - 1, map->nx);
+        iy[a] = clamp_index((long)j + a - 1, map->ny);
+        iz[a] = clamp_index((long)k + a - 1, map->nz);
+    }
+
+    double v[3] = {0.0, 0.0, 0.0};
+    for (int c = 0; c < 4; c++) {
+        for (int b = 0; b < 4; b++) {
+            double wyz = wy[b] * wz[c];
+            for (int a = 0; a < 4; a++) {
+                const double* d = map->data + point_index(map, ix[a], iy[b], iz[c]);
+                double w = wx[a] * wyz;
+                v[0] += w * d[0];
+                v[1] += w * d[1];
+                v[2] += w * d[2];
+            }
+        }
+    }
+    return vec3(v[0], v[1], v[2]);
+}
+
+Vector field_map_sample(const FieldMap* map, const Vector* position, FieldSampleMode mode) {
+    if (!map || !map->data || !position) return vec3(0.0, 0.0, 0.0);
+    return mode == FIELD_SAMPLE_TRICUBIC ? sample_tricubic(map, position) : sample_trilinear(map, position);
+}
+
+FieldErrorCode field_map_sample_entities(const FieldMap* map, const Entity* entities, size_t count,
+                                         FieldSampleMode mode, Vector* out) {
+    if (!map || !entities || !out) return FIELD_ERROR_NULL_POINTER;
+    if (!map->data) return FIELD_ERROR_INVALID_MAP;
+
+    long n = (long)count;
+    if (mode == FIELD_SAMPLE_TRICUBIC) {
+        #pragma omp parallel for schedule(static) if(n > FIELD_MAP_PARALLEL_THRESHOLD)
+        for (long i = 0; i < n; i++) {
+            out[i] = sample_tricubic(map, &entities[i].position);
+        }
+    } else {
+        #pragma omp parallel for schedule(static) if(n > FIELD_MAP_PARALLEL_THRESHOLD)
+        for (long i = 0; i < n; i++) {
+            out[i] = sample_trilinear(map, &entities[i].position);
+        }
+    }
+    return FIELD_SUCCESS;
+}
+
+FieldErrorCode field_map_apply(const FieldMap* map, Entity* entities, size_t count, FieldSampleMode mode) {
+    if (!map || !entities) return FIELD_ERROR_NULL_POINTER;
+    if (!map->data) return FIELD_ERROR_INVALID_MAP;
+
+    long n = (long)count;
+    #pragma omp parallel for schedule(static) if(n > FIELD_MAP_PARALLEL_THRESHOLD)
+    for (long i = 0; i < n; i++) {
+        Entity* e = &entities[i];
+        if (e->is_static) continue;
+        if (map->kind != FIELD_MAP_GRAVITATIONAL && e->mass < DBL_EPSILON) continue;
+
+        Vector f = mode == FIELD_SAMPLE_TRICUBIC ? sample_tricubic(map, &e->position)
+                                                 : sample_trilinear(map, &e->position);
+        switch (map->kind) {
+            case FIELD_MAP_GRAVITATIONAL:
+                e->acceleration = vec3_add(e->acceleration, f);
+                break;
+            case FIELD_MAP_ELECTRIC:
+                vec3_axpy(&e->acceleration, e->charge / e->mass, f);
+                break;
+            case FIELD_MAP_MAGNETIC:
+                vec3_axpy(&e->acceleration, e->charge / e->mass, vec3_cross(e->velocity, f));
+                break;
+        }
+    }
+    return FIELD_SUCCESS;
+}
@@ -0,0 +1,514 @@
+#include "../../include/core/hard_sphere.h"
+#include "../../include/core/collider.h"
+#include "../../include/core/time_flow.h"
+#include "../../include/mathlib/vec_math.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define NO_CELL UINT32_MAX
+
+enum {
+    EVENT_NONE,
+    EVENT_SPHERE,   // partner is the other sphere
+    EVENT_WALL,     // partner is axis * 2 + 1 for the upper wall, axis * 2 for the lower one
+    EVENT_CELL      // partner is axis * 2 + 1 when moving to the next cell along axis, axis * 2 for the previous one
+};
+
+void hard_sphere_default_config(HardSphereConfig* config) {
+    if (!config) return;
+    config->box_min = vec3(0.0, 0.0, 0.0);
+    config->box_max = vec3(1.0, 1.0, 1.0);
+    config->wall_restitution = 1.0;
+    config->max_cells = 0;
+    config->max_events = HARD_SPHERE_DEFAULT_MAX_EVENTS;
+}
+
+static double axis_of(Vector v, int axis) {
+    return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+
+static Vector velocity_of(const HardSphereSystem* sys, size_t i) {
+    const Entity* e = &sys->entities[i];
+    return e->is_static ? vec3(0.0, 0.0, 0.0) : e->velocity;
+}
+
+static Vector position_at(const HardSphereSystem* sys, size_t i, double t) {
+    const Entity* e = &sys->entities[i];
+    if (e->is_static) return e->position;
+    return vec3_madd(e->position, t - sys->local_time[i], e->velocity);
+}
+
+/**
+ * Move a sphere along its straight line to time t.
+ */
+static void advance_to(HardSphereSystem* sys, size_t i, double t) {
+    sys->entities[i].position = position_at(sys, i, t);
+    sys->local_time[i] = t;
+}
+
+// ---------------------------------------------------------------------------
+// indexed priority queue
+
+static void heap_swap(HardSphereSystem* sys, size_t a, size_t b) {
+    uint32_t ia = sys->heap[a], ib = sys->heap[b];
+    sys->heap[a] = ib;
+    sys->heap[b] = ia;
+    sys->heap_pos[ib] = (uint32_t)a;
+    sys->heap_pos[ia] = (uint32_t)b;
+}
+
+/**
+ * Restore the heap order after the event time of sphere i changed.
+ */
+static void heap_update(HardSphereSystem* sys, size_t i) {
+    size_t pos = sys->heap_pos[i];
+    double t = sys->event_time[i];
+
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (sys->event_time[sys->heap[parent]] <= t) break;
+        heap_swap(sys, pos, parent);
+        pos = parent;
+    }
+
+    for (;;) {
+        size_t child = 2 * pos + 1;
+        if (child >= sys->count) break;
+        if (child + 1 < sys->count && sys->event_time[sys->heap[child + 1]] < sys->event_time[sys->heap[child]]) {
+            child++;
+        }
+        if (sys->event_time[sys->heap[child]] >= t) break;
+        heap_swap(sys, pos, child);
+        pos = child;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// grid
+
+static size_t cell_coord(const HardSphereSystem* sys, Vector p, int axis) {
+    double g = (axis_of(p, axis) - axis_of(sys->config.box_min, axis)) / axis_of(sys->cell_size, axis);
+    size_t n = sys->cells[axis];
+    if (!(g > 0.0)) return 0;
+    size_t c = (size_t)g;
+    return c < n ? c : n - 1;
+}
+
+static void cell_insert(HardSphereSystem* sys, size_t i, uint32_t cell) {
+    uint32_t head = sys->cell_head[cell];
+    sys->cell_prev[i] = NO_CELL;
+    sys->cell_next[i] = head;
+    if (head != NO_CELL) sys->cell_prev[head] = (uint32_t)i;
+    sys->cell_head[cell] = (uint32_t)i;
+    sys->cell_of[i] = cell;
+}
+
+static void cell_remove(HardSphereSystem* sys, size_t i) {
+    uint32_t prev = sys->cell_prev[i], next = sys->cell_next[i];
+    if (prev != NO_CELL) sys->cell_next[prev] = next;
+    else sys->cell_head[sys->cell_of[i]] = next;
+    if (next != NO_CELL) sys->cell_prev[next] = prev;
+}
+
+static void build_cells(HardSphereSystem* sys) {
+    size_t cell_count = sys->cells[0] * sys->cells[1] * sys->cells[2];
+    for (size_t c = 0; c < cell_count; c++) sys->cell_head[c] = NO_CELL;
+    for (size_t i = 0; i < sys->count; i++) {
+        Vector p = sys->entities[i].position;
+        size_t cx = cell_coord(sys, p, 0), cy = cell_coord(sys, p, 1), cz = cell_coord(sys, p, 2);
+        cell_insert(sys, i, (uint32_t)((cz * sys->cells[1] + cy) * sys->cells[0] + cx));
+    }
+}
+
+/**
+ * Cells per axis: as many as fit with an edge of at least one diameter, reduced to at most max_cells in total.
+ */
+static void choose_grid(HardSphereSystem* sys, double diameter) {
+    size_t limit = sys->config.max_cells ? sys->config.max_cells : sys->count;
+    if (limit < 1) limit = 1;
+    if (limit > UINT32_MAX - 1) limit = UINT32_MAX - 1;
+
+    double n[3];
+    for (int a = 0; a < 3; a++) {
+        double extent = axis_of(sys->config.box_max, a) - axis_of(sys->config.box_min, a);
+        n[a] = floor(extent / diameter);
+        if (n[a] < 1.0) n[a] = 1.0;
+        if (n[a] > (double)limit) n[a] = (double)limit;
+    }
+    double total = n[0] * n[1] * n[2];
+    if (total > (double)limit) {
+        double f = cbrt((double)limit / total);
+        for (int a = 0; a < 3; a++) n[a] = n[a] * f < 1.0 ? 1.0 : floor(n[a] * f);
+    }
+    while (n[0] * n[1] * n[2] > (double)limit) {
+        int largest = n[1] > n[0] ? 1 : 0;
+        if (n[2] > n[largest]) largest = 2;
+        n[largest] -= 1.0;
+    }
+
+    for (int a = 0; a < 3; a++) sys->cells[a] = (size_t)n[a];
+    Vector extent = vec3_sub(sys->config.box_max, sys->config.box_min);
+    sys->cell_size = vec3(extent.x / n[0], extent.y / n[1], extent.z / n[2]);
+}
+
+// ---------------------------------------------------------------------------
+// prediction
+
+/**
+ * Time until two spheres touch while approaching, INFINITY if they never do. Overlapping spheres that approach
+ * collide immediately.
+ */
+static double contact_time(const HardSphereSystem* sys, size_t i, size_t k, Vector pi, Vector vi) {
+    Vector dr = vec3_sub(position_at(sys, k, sys->time), pi);
+    Vector dv = vec3_sub(velocity_of(sys, k), vi);
+    double b = vec3_dot(dr, dv);
+    if (b >= 0.0) return INFINITY;
+
+    double sigma = sys->radii[i] + sys->radii[k];
+    double c = vec3_dot(dr, dr) - sigma * sigma;
+    if (c <= 0.0) return 0.0;
+
+    double dv2 = vec3_dot(dv, dv);
+    double d = b * b - dv2 * c;
+    if (d < 0.0) return INFINITY;
+    // smaller root written so it does not cancel
+    return c / (-b + sqrt(d));
+}
+
+/**
+ * Predict the next event of sphere i from the current time and reposition it in the queue.
+ *
+ * The earliest sphere-sphere collision is kept separately from the wall and cell times. A cell crossing does
+ * not change the trajectory, so after one (entered_face >= 0) only the layer of cells that just became
+ * adjacent is searched and the previous candidate is kept. Pass -1 after a change of velocity.
+ */
+static void predict(HardSphereSystem* sys, size_t i, int entered_face) {
+    const Entity* e = &sys->entities[i];
+    double best = INFINITY;
+    unsigned char type = EVENT_NONE;
+    uint32_t partner = 0, partner_count = 0;
+
+    if (!e->is_static) {
+        advance_to(sys, i, sys->time);
+        Vector p = e->position, v = e->velocity;
+        double r = sys->radii[i];
+        uint32_t cell = sys->cell_of[i];
+        size_t c[3] = {cell % sys->cells[0], cell / sys->cells[0] % sys->cells[1],
+                       cell / sys->cells[0] / sys->cells[1]};
+
+        for (int a = 0; a < 3; a++) {
+            double x = axis_of(p, a), va = axis_of(v, a);
+            if (va == 0.0) continue;
+            double lo = axis_of(sys->config.box_min, a), size = axis_of(sys->cell_size, a);
+            double wall = va > 0.0 ? axis_of(sys->config.box_max, a) - r : lo + r;
+            double t = (wall - x) / va;
+            if (t < 0.0) t = 0.0;
+            if (t < best) {
+                best = t;
+                type = EVENT_WALL;
+                partner = (uint32_t)(a * 2 + (va > 0.0));
+            }
+
+            if (va > 0.0 ? c[a] + 1 < sys->cells[a] : c[a] > 0) {
+                double face = lo + (double)(c[a] + (va > 0.0)) * size;
+                t = (face - x) / va;
+                if (t < 0.0) t = 0.0;
+                if (t < best) {
+                    best = t;
+                    type = EVENT_CELL;
+                    partner = (uint32_t)(a * 2 + (va > 0.0));
+                }
+            }
+        }
+        best += sys->time;
+
+        if (entered_face < 0) {
+            sys->sphere_time[i] = INFINITY;
+        }
+        double candidate = sys->sphere_time[i];
+        uint32_t candidate_partner = sys->sphere_partner[i];
+        uint32_t candidate_count = sys->sphere_partner_count[i];
+
+        size_t lo[3], hi[3];
+        bool scan = true;
+        for (int a = 0; a < 3; a++) {
+            lo[a] = c[a] > 0 ? c[a] - 1 : 0;
+            hi[a] = c[a] + 1 < sys->cells[a] ? c[a] + 1 : c[a];
+        }
+        if (entered_face >= 0) {
+            int a = entered_face / 2;
+            if (entered_face % 2) {
+                scan = c[a] + 1 < sys->cells[a];
+                lo[a] = hi[a] = c[a] + 1;
+            } else {
+                scan = c[a] > 0;
+                lo[a] = hi[a] = c[a] - 1;
+            }
+        }
+
+        for (size_t z = lo[2]; scan && z <= hi[2]; z++) {
+            for (size_t y = lo[1]; y <= hi[1]; y++) {
+                for (size_t x = lo[0]; x <= hi[0]; x++) {
+                    uint32_t k = sys->cell_head[(z * sys->cells[1] + y) * sys->cells[0] + x];
+                    for (; k != NO_CELL; k = sys->cell_next[k]) {
+                        if (k == i) continue;
+                        double t = sys->time + contact_time(sys, i, k, p, v);
+                        if (t < candidate) {
+                            candidate = t;
+                            candidate_partner = k;
+                            candidate_count = sys->collision_count[k];
+                        }
+                    }
+                }
+            }
+        }
+
+        sys->sphere_time[i] = candidate;
+        sys->sphere_partner[i] = candidate_partner;
+        sys->sphere_partner_count[i] = candidate_count;
+        if (candidate < best) {
+            best = candidate;
+            type = EVENT_SPHERE;
+            partner = candidate_partner;
+            partner_count = candidate_count;
+        }
+    }
+
+    sys->event_time[i] = best;
+    sys->event_type[i] = type;
+    sys->event_partner[i] = partner;
+    sys->event_partner_count[i] = partner_count;
+    heap_update(sys, i);
+}
+
+static HardSphereErrorCode check_inside(const HardSphereSystem* sys, const double* radii) {
+    for (size_t i = 0; i < sys->count; i++) {
+        Vector p = sys->entities[i].position;
+        double r = radii[i];
+        for (int a = 0; a < 3; a++) {
+            double x = axis_of(p, a);
+            if (!(x >= axis_of(sys->config.box_min, a) + r && x <= axis_of(sys->config.box_max, a) - r)) {
+                return HARD_SPHERE_ERROR_OUTSIDE_BOX;
+            }
+        }
+    }
+    return HARD_SPHERE_SUCCESS;
+}
+
+/**
+ * Rebuild the grid and the queue from the current positions at sys->time.
+ */
+static void predict_all(HardSphereSystem* sys) {
+    build_cells(sys);
+    for (size_t i = 0; i < sys->count; i++) {
+        sys->event_time[i] = INFINITY;
+        sys->heap[i] = (uint32_t)i;
+        sys->heap_pos[i] = (uint32_t)i;
+    }
+    for (size_t i = 0; i < sys->count; i++) {
+        predict(sys, i, -1);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+HardSphereErrorCode hard_sphere_init(HardSphereSystem* sys, Entity* entities, const double* radii, size_t count,
+                                     const HardSphereConfig* config) {
+    if (!sys || (count > 0 && (!entities || !radii))) return HARD_SPHERE_ERROR_NULL_POINTER;
+    memset(sys, 0, sizeof(*sys));
+    if (config) sys->config = *config;
+    else hard_sphere_default_config(&sys->config);
+
+    const HardSphereConfig* c = &sys->config;
+    if (!(c->box_max.x > c->box_min.x && c->box_max.y > c->box_min.y && c->box_max.z > c->box_min.z) ||
+        !(c->wall_restitution >= 0.0 && c->wall_restitution <= 1.0) || count >= NO_CELL) {
+        return HARD_SPHERE_ERROR_INVALID_CONFIG;
+    }
+
+    Vector extent = vec3_sub(c->box_max, c->box_min);
+    double smallest = fmin(extent.x, fmin(extent.y, extent.z));
+    double diameter = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        if (!(radii[i] > 0.0) || !(2.0 * radii[i] <= smallest)) return HARD_SPHERE_ERROR_INVALID_RADIUS;
+        if (2.0 * radii[i] > diameter) diameter = 2.0 * radii[i];
+        // a massless sphere takes no impulse and would collide with its partner again at once, forever
+        if (!entities[i].is_static && !(entities[i].mass > 0.0 && isfinite(entities[i].mass))) {
+            return HARD_SPHERE_ERROR_INVALID_MASS;
+        }
+    }
+
+    sys->entities = entities;
+    sys->count = count;
+    HardSphereErrorCode rc = check_inside(sys, radii);
+    if (rc != HARD_SPHERE_SUCCESS) {
+        memset(sys, 0, sizeof(*sys));
+        return rc;
+    }
+    choose_grid(sys, diameter > 0.0 ? diameter : smallest);
+
+    size_t n = count ? count : 1;
+    size_t cell_count = sys->cells[0] * sys->cells[1] * sys->cells[2];
+    sys->radii = malloc(n * sizeof(double));
+    sys->local_time = calloc(n, sizeof(double));
+    sys->collision_count = calloc(n, sizeof(uint32_t));
+    sys->event_time = malloc(n * sizeof(double));
+    sys->event_partner = malloc(n * sizeof(uint32_t));
+    sys->event_partner_count = malloc(n * sizeof(uint32_t));
+    sys->event_type = malloc(n);
+    sys->sphere_time = malloc(n * sizeof(double));
+    sys->sphere_partner = malloc(n * sizeof(uint32_t));
+    sys->sphere_partner_count = malloc(n * sizeof(uint32_t));
+    sys->heap = malloc(n * sizeof(uint32_t));
+    sys->heap_pos = malloc(n * sizeof(uint32_t));
+    sys->cell_head = malloc(cell_count * sizeof(uint32_t));
+    sys->cell_next = malloc(n * sizeof(uint32_t));
+    sys->cell_prev = malloc(n * sizeof(uint32_t));
+    sys->cell_of = malloc(n * sizeof(uint32_t));
+    if (!sys->radii || !sys->local_time || !sys->collision_count || !sys->event_time || !sys->event_partner ||
+        !sys->event_partner_count || !sys->event_type || !sys->sphere_time || !sys->sphere_partner ||
+        !sys->sphere_partner_count || !sys->heap || !sys->heap_pos || !sys->cell_head ||
+        !sys->cell_next || !sys->cell_prev || !sys->cell_of) {
+        hard_sphere_free(sys);
+        return HARD_SPHERE_ERROR_OUT_OF_MEMORY;
+    }
+    if (count) memcpy(sys->radii, radii, count * sizeof(double));
+
+    sys->wall = new_entity(NULL, 0.0, 0.0, NULL, NULL, NULL, c->wall_restitution, true, true);
+    predict_all(sys);
+    return HARD_SPHERE_SUCCESS;
+}
+
+void hard_sphere_free(HardSphereSystem* sys) {
+    if (!sys) return;
+    free(sys->radii);
+    free(sys->local_time);
+    free(sys->collision_count);
+    free(sys->event_time);
+    free(sys->event_partner);
+    free(sys->event_partner_count);
+    free(sys->event_type);
+    free(sys->sphere_time);
+    free(sys->sphere_partner);
+    free(sys->sphere_partner_count);
+    free(sys->heap);
+    free(sys->heap_pos);
+    free(sys->cell_head);
+    free(sys->cell_next);
+    free(sys->cell_prev);
+    free(sys->cell_of);
+    memset(sys, 0, sizeof(*sys));
+}
+
+static void synchronise(HardSphereSystem* sys) {
+    for (size_t i = 0; i < sys->count; i++) {
+        advance_to(sys, i, sys->time);
+    }
+}
+
+static void collide_spheres(HardSphereSystem* sys, size_t i, size_t j) {
+    advance_to(sys, i, sys->time);
+    advance_to(sys, j, sys->time);
+    double distance, loss;
+    Vector normal = vec3_normalize(vec3_sub(sys->entities[j].position, sys->entities[i].position), &distance);
+    apply_restitution_impulse(&sys->entities[i], &sys->entities[j], &normal, &loss);
+    sys->collision_count[i]++;
+    sys->collision_count[j]++;
+    sys->stats.collisions++;
+    sys->stats.energy_loss += loss;
+    predict(sys, i, -1);
+    predict(sys, j, -1);
+}
+
+static void collide_wall(HardSphereSystem* sys, size_t i, uint32_t face) {
+    advance_to(sys, i, sys->time);
+    int axis = (int)(face / 2);
+    double sign = face % 2 ? 1.0 : -1.0;
+    Vector normal = vec3(axis == 0 ? sign : 0.0, axis == 1 ? sign : 0.0, axis == 2 ? sign : 0.0);
+    double loss;
+    apply_restitution_impulse(&sys->entities[i], &sys->wall, &normal, &loss);
+    sys->collision_count[i]++;
+    sys->stats.wall_collisions++;
+    sys->stats.energy_loss += loss;
+    predict(sys, i, -1);
+}
+
+static void cross_cell(HardSphereSystem* sys, size_t i, uint32_t face) {
+    size_t axis = face / 2;
+    size_t stride = axis == 0 ? 1 : axis == 1 ? sys->cells[0] : sys->cells[0] * sys->cells[1];
+    uint32_t cell = face % 2 ? sys->cell_of[i] + (uint32_t)stride : sys->cell_of[i] - (uint32_t)stride;
+    cell_remove(sys, i);
+    cell_insert(sys, i, cell);
+    sys->stats.cell_crossings++;
+    predict(sys, i, (int)face);
+}
+
+HardSphereErrorCode hard_sphere_advance(HardSphereSystem* sys, double dt) {
+    if (!sys) return HARD_SPHERE_ERROR_NULL_POINTER;
+    if (!(dt >= 0.0)) return HARD_SPHERE_ERROR_INVALID_CONFIG;
+
+    double start = wall_clock_ms();
+    double t_end = sys->time + dt;
+    size_t processed = 0;
+    HardSphereErrorCode rc = HARD_SPHERE_SUCCESS;
+
+    while (sys->count > 0) {
+        uint32_t i = sys->heap[0];
+        double t = sys->event_time[i];
+        if (!(t <= t_end)) break;
+        if (sys->config.max_events && processed == sys->config.max_events) {
+            rc = HARD_SPHERE_ERROR_EVENT_LIMIT;
+            break;
+        }
+        processed++;
+        if (t > sys->time) sys->time = t;
+
+        uint32_t partner = sys->event_partner[i];
+        switch (sys->event_type[i]) {
+            case EVENT_SPHERE:
+                // the partner changed course since this was predicted
+                if (sys->collision_count[partner] != sys->event_partner_count[i]) {
+                    sys->stats.stale_events++;
+                    predict(sys, i, -1);
+                } else {
+                    collide_spheres(sys, i, partner);
+                }
+                break;
+            case EVENT_WALL:
+                collide_wall(sys, i, partner);
+                break;
+            case EVENT_CELL:
+                cross_cell(sys, i, partner);
+                break;
+            default:
+                predict(sys, i, -1);
+                break;
+        }
+    }
+
+    if (rc == HARD_SPHERE_SUCCESS) sys->time = t_end;
+    synchronise(sys);
+
+    sys->stats.run_ms += wall_clock_ms() - start;
+    if (sys->stats.run_ms > 0.0) {
+        sys->stats.collisions_per_second = (double)sys->stats.collisions / (sys->stats.run_ms * 1e-3);
+    }
+    return rc;
+}
+
+HardSphereErrorCode hard_sphere_invalidate(HardSphereSystem* sys) {
+    if (!sys) return HARD_SPHERE_ERROR_NULL_POINTER;
+    for (size_t i = 0; i < sys->count; i++) {
+        sys->local_time[i] = sys->time;
+    }
+    HardSphereErrorCode rc = check_inside(sys, sys->radii);
+    if (rc != HARD_SPHERE_SUCCESS) return rc;
+    predict_all(sys);
+    return HARD_SPHERE_SUCCESS;
+}
+
+HardSphereStats hard_sphere_stats(const HardSphereSystem* sys) {
+    HardSphereStats empty = {0};
+    return sys ? sys->stats : empty;
+}
@@ -0,0 +1,431 @@
+#include "../../include/core/history.h"
+#include "../../include/core/time_flow.h"
+#include <stdlib.h>
+
+// worst case bytes of one entity record: index gap varint, change mask, 10 bytes per value (64 bit varint)
+#define RECORD_MAX_BYTES (10 + 2 + 10 * HISTORY_VALUES)
+
+// quantized references are grid indices below 2^62 in magnitude so their deltas cannot overflow,
+// non-finite and larger values get the reference QUANT_RAW and are stored as raw bits
+#define QUANT_LIMIT 4611686018427387904.0
+#define QUANT_RAW ((uint64_t)1 << 63)
+
+void history_default_config(HistoryConfig* config) {
+    if (!config) return;
+    config->keyframe_interval = 64;
+    config->max_bytes = 0;
+    config->mode = HISTORY_LOSSLESS;
+    config->position_quantum = 1e-9;
+    config->velocity_quantum = 1e-9;
+    config->quaternion_quantum = 1e-9;
+    config->angular_velocity_quantum = 1e-9;
+}
+
+static void load_values(const Entity* e, double v[HISTORY_VALUES]) {
+    v[0] = e->position.x;  v[1] = e->position.y;  v[2] = e->position.z;
+    v[3] = e->velocity.x;  v[4] = e->velocity.y;  v[5] = e->velocity.z;
+    v[6] = e->quaternion[0]; v[7] = e->quaternion[1]; v[8] = e->quaternion[2]; v[9] = e->quaternion[3];
+    v[10] = e->angular_velocity.x; v[11] = e->angular_velocity.y; v[12] = e->angular_velocity.z;
+}
+
+static void store_values(Entity* e, const double v[HISTORY_VALUES]) {
+    e->position.x = v[0];  e->position.y = v[1];  e->position.z = v[2];
+    e->velocity.x = v[3];  e->velocity.y = v[4];  e->velocity.z = v[5];
+    e->quaternion[0] = v[6]; e->quaternion[1] = v[7]; e->quaternion[2] = v[8]; e->quaternion[3] = v[9];
+    e->angular_velocity.x = v[10]; e->angular_velocity.y = v[11]; e->angular_velocity.z = v[12];
+}
+
+static double column_quantum(const HistoryConfig* c, int column) {
+    if (column < 3) return c->position_quantum;
+    if (column < 6) return c->velocity_quantum;
+    if (column < 10) return c->quaternion_quantum;
+    return c->angular_velocity_quantum;
+}
+
+/**
+ * Encoder reference of a value: its bit pattern (lossless) or its grid index (quantized), QUANT_RAW for
+ * values off the grid.
+ */
+static uint64_t to_reference(const HistoryConfig* c, int column, double v) {
+    if (c->mode == HISTORY_QUANTIZED) {
+        double g = v / column_quantum(c, column);
+        if (!(fabs(g) < QUANT_LIMIT)) return QUANT_RAW;
+        return (uint64_t)llround(g);
+    }
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static double from_reference(const HistoryConfig* c, int column, uint64_t r) {
+    if (c->mode == HISTORY_QUANTIZED) {
+        return (double)(int64_t)r * column_quantum(c, column);
+    }
+    double v;
+    memcpy(&v, &r, sizeof(v));
+    return v;
+}
+
+static unsigned char* put_varint(unsigned char* p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+static const unsigned char* get_varint(const unsigned char* p, uint64_t* v) {
+    uint64_t r = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        r |= (uint64_t)(*p++ & 0x7f) << shift;
+        shift += 7;
+    }
+    *v = r | (uint64_t)*p++ << shift;
+    return p;
+}
+
+/**
+ * Lossless values are stored as the XOR with the previous bits minus its leading and trailing zero bytes,
+ * a header byte holds both counts. Slowly changing doubles share sign, exponent and high mantissa bytes.
+ */
+static unsigned char* put_xor(unsigned char* p, uint64_t x) {
+    int lz = 0, tz = 0;
+    while (lz < 7 && !(x >> (56 - 8 * lz) & 0xff)) lz++;
+    while (tz < 7 - lz && !(x >> (8 * tz) & 0xff)) tz++;
+    *p++ = (unsigned char)(lz << 4 | tz);
+    for (int b = tz; b < 8 - lz; b++) {
+        *p++ = (unsigned char)(x >> (8 * b));
+    }
+    return p;
+}
+
+static const unsigned char* get_xor(const unsigned char* p, uint64_t* x) {
+    int lz = *p >> 4, tz = *p & 0xf;
+    p++;
+    uint64_t r = 0;
+    for (int b = tz; b < 8 - lz; b++) {
+        r |= (uint64_t)*p++ << (8 * b);
+    }
+    *x = r;
+    return p;
+}
+
+static size_t keyframe_bytes(const History* h) {
+    return h->entity_count * HISTORY_VALUES * sizeof(double) + h->config.keyframe_interval * sizeof(size_t);
+}
+
+HistoryErrorCode history_init(History* h, const HistoryConfig* config, size_t entity_count) {
+    if (!h) return HISTORY_ERROR_NULL_POINTER;
+    memset(h, 0, sizeof(*h));
+    if (config) {
+        h->config = *config;
+    } else {
+        history_default_config(&h->config);
+    }
+
+    const HistoryConfig* c = &h->config;
+    if (c->keyframe_interval == 0 || entity_count == 0) return HISTORY_ERROR_INVALID_CONFIG;
+    if (c->mode == HISTORY_QUANTIZED && !(c->position_quantum > 0.0 && c->velocity_quantum > 0.0 &&
+                                          c->quaternion_quantum > 0.0 && c->angular_velocity_quantum > 0.0)) {
+        return HISTORY_ERROR_INVALID_CONFIG;
+    }
+
+    h->entity_count = entity_count;
+    size_t values = entity_count * HISTORY_VALUES;
+    h->reference = malloc(values * sizeof(uint64_t));
+    h->decode_reference = malloc(values * sizeof(uint64_t));
+    h->decode_values = malloc(values * sizeof(double));
+    h->scratch = malloc(entity_count * RECORD_MAX_BYTES + 10);
+    if (!h->reference || !h->decode_reference || !h->decode_values || !h->scratch) {
+        history_free(h);
+        return HISTORY_ERROR_OUT_OF_MEMORY;
+    }
+    return HISTORY_SUCCESS;
+}
+
+static void segment_free(HistorySegment* s) {
+    free(s->keyframe);
+    free(s->deltas);
+    free(s->step_end);
+}
+
+void history_free(History* h) {
+    if (!h) return;
+    for (size_t i = 0; i < h->segment_count; i++) {
+        segment_free(&h->segments[i]);
+    }
+    free(h->segments);
+    free(h->reference);
+    free(h->decode_reference);
+    free(h->decode_values);
+    free(h->scratch);
+    memset(h, 0, sizeof(*h));
+}
+
+static void drop_oldest_segment(History* h) {
+    HistorySegment* s = &h->segments[0];
+    h->stats.keyframe_bytes -= keyframe_bytes(h);
+    h->stats.delta_bytes -= s->delta_capacity;
+    segment_free(s);
+    memmove(h->segments, h->segments + 1, (h->segment_count - 1) * sizeof(HistorySegment));
+    h->segment_count--;
+    h->stats.segments_dropped++;
+}
+
+static void enforce_budget(History* h) {
+    if (h->config.max_bytes == 0) return;
+    // the newest segment is always kept, it holds the encoder reference
+    while (h->segment_count > 1 && h->stats.keyframe_bytes + h->stats.delta_bytes > h->config.max_bytes) {
+        drop_oldest_segment(h);
+    }
+}
+
+static HistoryErrorCode start_segment(History* h, const Entity* entities) {
+    if (h->segment_count > 0) {
+        // the previous segment is complete, give back its spare delta capacity
+        HistorySegment* last = &h->segments[h->segment_count - 1];
+        if (last->delta_capacity > last->delta_size && last->delta_size > 0) {
+            unsigned char* d = realloc(last->deltas, last->delta_size);
+            if (d) {
+                h->stats.delta_bytes -= last->delta_capacity - last->delta_size;
+                last->deltas = d;
+                last->delta_capacity = last->delta_size;
+            }
+        }
+    }
+    if (h->segment_count == h->segment_capacity) {
+        size_t capacity = h->segment_capacity ? 2 * h->segment_capacity : 16;
+        HistorySegment* s = realloc(h->segments, capacity * sizeof(HistorySegment));
+        if (!s) return HISTORY_ERROR_OUT_OF_MEMORY;
+        h->segments = s;
+        h->segment_capacity = capacity;
+    }
+
+    HistorySegment* s = &h->segments[h->segment_count];
+    memset(s, 0, sizeof(*s));
+    s->keyframe = malloc(h->entity_count * HISTORY_VALUES * sizeof(double));
+    s->step_end = malloc(h->config.keyframe_interval * sizeof(size_t));
+    if (!s->keyframe || !s->step_end) {
+        segment_free(s);
+        return HISTORY_ERROR_OUT_OF_MEMORY;
+    }
+    s->first_step = h->next_step;
+    s->step_count = 1;
+
+    for (size_t i = 0; i < h->entity_count; i++) {
+        double* v = s->keyframe + i * HISTORY_VALUES;
+        load_values(&entities[i], v);
+        for (int c = 0; c < HISTORY_VALUES; c++) {
+            h->reference[i * HISTORY_VALUES + c] = to_reference(&h->config, c, v[c]);
+        }
+    }
+    h->segment_count++;
+    h->stats.keyframe_bytes += keyframe_bytes(h);
+    return HISTORY_SUCCESS;
+}
+
+/**
+ * Encode the changes since the reference into scratch: records of (index gap + 1, change mask, values),
+ * terminated by a zero gap. A quantized value is the zigzag delta to its reference plus one, or 0 followed
+ * by the 8 raw bytes of an off-grid value. Off-grid values are written every step, a reference of QUANT_RAW
+ * counts as 0 for the next delta.
+ */
+static size_t encode_step(History* h, const Entity* entities) {
+    const HistoryConfig* cfg = &h->config;
+    unsigned char* p = h->scratch;
+    size_t last = (size_t)-1;
+
+    for (size_t i = 0; i < h->entity_count; i++) {
+        if (entities[i].is_static) continue;
+
+        double v[HISTORY_VALUES];
+        load_values(&entities[i], v);
+        uint64_t* ref = h->reference + i * HISTORY_VALUES;
+
+        unsigned char* start = p;
+        p = put_varint(p, i - last);
+        unsigned char* mask_at = p;
+        p += 2;
+        unsigned mask = 0;
+        for (int c = 0; c < HISTORY_VALUES; c++) {
+            uint64_t r = to_reference(cfg, c, v[c]);
+            bool raw = cfg->mode == HISTORY_QUANTIZED && r == QUANT_RAW;
+            if (r == ref[c] && !raw) continue;
+            mask |= 1u << c;
+            if (raw) {
+                *p++ = 0;
+                memcpy(p, &v[c], sizeof(double));
+                p += sizeof(double);
+            } else if (cfg->mode == HISTORY_QUANTIZED) {
+                int64_t d = (int64_t)(r - (ref[c] == QUANT_RAW ? 0 : ref[c]));
+                p = put_varint(p, (((uint64_t)d << 1) ^ (uint64_t)(d >> 63)) + 1);
+            } else {
+                p = put_xor(p, r ^ ref[c]);
+            }
+            ref[c] = r;
+        }
+        if (mask == 0) {
+            // unchanged (resting) body, drop the record
+            p = start;
+            continue;
+        }
+        mask_at[0] = (unsigned char)mask;
+        mask_at[1] = (unsigned char)(mask >> 8);
+        last = i;
+    }
+    p = put_varint(p, 0);
+    return (size_t)(p - h->scratch);
+}
+
+static const unsigned char* decode_step(const History* h, const unsigned char* p) {
+    const HistoryConfig* cfg = &h->config;
+    size_t index = (size_t)-1;
+    uint64_t gap;
+    for (p = get_varint(p, &gap); gap != 0; p = get_varint(p, &gap)) {
+        index += gap;
+        unsigned mask = p[0] | (unsigned)p[1] << 8;
+        p += 2;
+        uint64_t* ref = h->decode_reference + index * HISTORY_VALUES;
+        double* val = h->decode_values + index * HISTORY_VALUES;
+        for (int c = 0; c < HISTORY_VALUES; c++) {
+            if (!(mask >> c & 1)) continue;
+            uint64_t x;
+            if (cfg->mode == HISTORY_QUANTIZED) {
+                p = get_varint(p, &x);
+                if (x == 0) {
+                    memcpy(&val[c], p, sizeof(double));
+                    p += sizeof(double);
+                    ref[c] = QUANT_RAW;
+                    continue;
+                }
+                x--;
+                ref[c] = (ref[c] == QUANT_RAW ? 0 : ref[c]) + ((x >> 1) ^ (0 - (x & 1)));
+            } else {
+                p = get_xor(p, &x);
+                ref[c] ^= x;
+            }
+            val[c] = from_reference(cfg, c, ref[c]);
+        }
+    }
+    return p;
+}
+
+HistoryErrorCode history_record(History* h, const Entity* entities, size_t count, size_t* step) {
+    if (!h || !entities) return HISTORY_ERROR_NULL_POINTER;
+    if (count != h->entity_count) return HISTORY_ERROR_COUNT_MISMATCH;
+    double t0 = wall_clock_ms();
+
+    HistorySegment* s = h->segment_count ? &h->segments[h->segment_count - 1] : NULL;
+    if (!s || s->step_count == h->config.keyframe_interval) {
+        HistoryErrorCode err = start_segment(h, entities);
+        if (err != HISTORY_SUCCESS) return err;
+    } else {
+        size_t bytes = encode_step(h, entities);
+        if (s->delta_size + bytes > s->delta_capacity) {
+            size_t capacity = s->delta_capacity + s->delta_capacity / 2;
+            if (capacity < s->delta_size + bytes) capacity = s->delta_size + bytes;
+            unsigned char* d = realloc(s->deltas, capacity);
+            if (!d) {
+                // the reference already moved on, keep it consistent with the stored steps
+                history_truncate(h, h->next_step - 1);
+                return HISTORY_ERROR_OUT_OF_MEMORY;
+            }
+            h->stats.delta_bytes += capacity - s->delta_capacity;
+            s->deltas = d;
+            s->delta_capacity = capacity;
+        }
+        memcpy(s->deltas + s->delta_size, h->scratch, bytes);
+        s->delta_size += bytes;
+        s->step_end[s->step_count - 1] = s->delta_size;
+        s->step_count++;
+    }
+
+    if (step) *step = h->next_step;
+    h->next_step++;
+    h->stats.steps_recorded++;
+    enforce_budget(h);
+    h->stats.last_record_ms = wall_clock_ms() - t0;
+    return HISTORY_SUCCESS;
+}
+
+static const HistorySegment* find_segment(const History* h, size_t step) {
+    if (h->segment_count == 0 || step < h->segments[0].first_step || step >= h->next_step) return NULL;
+    size_t lo = 0, hi = h->segment_count - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi + 1) / 2;
+        if (h->segments[mid].first_step <= step) lo = mid;
+        else hi = mid - 1;
+    }
+    return &h->segments[lo];
+}
+
+/**
+ * Rebuild the state of step into decode_values / decode_reference from its keyframe.
+ */
+static void decode_to(History* h, const HistorySegment* s, size_t step) {
+    size_t values = h->entity_count * HISTORY_VALUES;
+    memcpy(h->decode_values, s->keyframe, values * sizeof(double));
+    for (size_t i = 0; i < values; i++) {
+        h->decode_reference[i] = to_reference(&h->config, (int)(i % HISTORY_VALUES), s->keyframe[i]);
+    }
+    const unsigned char* p = s->deltas;
+    for (size_t k = s->first_step; k < step; k++) {
+        p = decode_step(h, p);
+    }
+}
+
+HistoryErrorCode history_restore(History* h, size_t step, Entity* entities, size_t count) {
+    if (!h || !entities) return HISTORY_ERROR_NULL_POINTER;
+    if (count != h->entity_count) return HISTORY_ERROR_COUNT_MISMATCH;
+    double t0 = wall_clock_ms();
+
+    const HistorySegment* s = find_segment(h, step);
+    if (!s) return HISTORY_ERROR_STEP_NOT_AVAILABLE;
+    decode_to(h, s, step);
+    for (size_t i = 0; i < count; i++) {
+        store_values(&entities[i], h->decode_values + i * HISTORY_VALUES);
+    }
+
+    h->stats.last_restore_ms = wall_clock_ms() - t0;
+    return HISTORY_SUCCESS;
+}
+
+HistoryErrorCode history_truncate(History* h, size_t step) {
+    if (!h) return HISTORY_ERROR_NULL_POINTER;
+    const HistorySegment* found = find_segment(h, step);
+    if (!found) return HISTORY_ERROR_STEP_NOT_AVAILABLE;
+
+    size_t keep = (size_t)(found - h->segments) + 1;
+    while (h->segment_count > keep) {
+        HistorySegment* last = &h->segments[h->segment_count - 1];
+        h->stats.keyframe_bytes -= keyframe_bytes(h);
+        h->stats.delta_bytes -= last->delta_capacity;
+        segment_free(last);
+        h->segment_count--;
+    }
+
+    HistorySegment* s = &h->segments[keep - 1];
+    s->step_count = step - s->first_step + 1;
+    s->delta_size = s->step_count > 1 ? s->step_end[s->step_count - 2] : 0;
+
+    decode_to(h, s, step);
+    memcpy(h->reference, h->decode_reference, h->entity_count * HISTORY_VALUES * sizeof(uint64_t));
+    h->next_step = step + 1;
+    return HISTORY_SUCCESS;
+}
+
+HistoryStats history_stats(const History* h) {
+    HistoryStats st;
+    memset(&st, 0, sizeof(st));
+    if (!h) return st;
+    st = h->stats;
+    st.bytes = st.keyframe_bytes + st.delta_bytes;
+    if (h->segment_count > 0) {
+        st.first_step = h->segments[0].first_step;
+        st.last_step = h->next_step - 1;
+        st.bytes_per_step = (double)st.bytes / (double)(h->next_step - st.first_step);
+    }
+    return st;
+}
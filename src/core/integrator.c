@@ -0,0 +1,311 @@
+#include "../../include/core/integrator.h"
+#include "../../include/core/movement.h"
+#include "../../include/mathlib/vec_math.h"
+#include <stdlib.h>
+
+#define STATE_STRIDE 6
+#define DOPRI_BUFFERS 9
+// consecutive rejected substeps before Dormand-Prince gives up, the step shrinks at least 5x per rejection
+#define DOPRI_MAX_REJECTIONS 64
+
+// Dormand-Prince 5(4) tableau, the 5th order weights equal the last stage row (FSAL)
+static const double dp_a[7][6] = {
+    {0},
+    {1.0/5.0},
+    {3.0/40.0, 9.0/40.0},
+    {44.0/45.0, -56.0/15.0, 32.0/9.0},
+    {19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0},
+    {9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0},
+    {35.0/384.0, 0.0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0}
+};
+
+// difference between the 5th and embedded 4th order weights
+static const double dp_e[7] = {
+    71.0/57600.0, 0.0, -71.0/16695.0, 71.0/1920.0, -17253.0/339200.0, 22.0/525.0, -1.0/40.0
+};
+
+ErrorCode integrator_init(Integrator* it, IntegratorType type, AccelerationFn accelerations, void* user) {
+    if (!it || !accelerations) {
+        return OPERATION_SET_FAILED;
+    }
+    memset(it, 0, sizeof(*it));
+    it->type = type;
+    it->accelerations = accelerations;
+    it->user = user;
+    it->abs_tol = 1e-12;
+    it->rel_tol = 1e-9;
+    it->dt_min = 0.0;
+    it->dt_max = INFINITY;
+    return OPERATION_SET_SUCCESS;
+}
+
+void integrator_free(Integrator* it) {
+    if (!it) return;
+    free(it->scratch);
+    it->scratch = NULL;
+    it->scratch_capacity = 0;
+}
+
+void integrator_invalidate(Integrator* it) {
+    if (it) it->accelerations_valid = false;
+}
+
+static void evaluate_accelerations(Integrator* it, Entity* entities, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        entities[i].acceleration.x = 0.0;
+        entities[i].acceleration.y = 0.0;
+        entities[i].acceleration.z = 0.0;
+    }
+    it->accelerations(entities, count, it->user);
+    it->force_evaluations++;
+    it->accelerations_valid = true;
+}
+
+static void verlet_step(Integrator* it, Entity* entities, size_t count, double dt) {
+    if (!it->accelerations_valid) {
+        evaluate_accelerations(it, entities, count);
+    }
+
+    double half = 0.5 * dt;
+    for (size_t i = 0; i < count; i++) {
+        Entity* e = &entities[i];
+        if (e->is_static) continue;
+        vec3_axpy(&e->velocity, half, e->acceleration);
+        vec3_axpy(&e->position, dt, e->velocity);
+    }
+
+    evaluate_accelerations(it, entities, count);
+
+    for (size_t i = 0; i < count; i++) {
+        Entity* e = &entities[i];
+        if (e->is_static) continue;
+        vec3_axpy(&e->velocity, half, e->acceleration);
+    }
+}
+
+static void euler_step(Integrator* it, Entity* entities, size_t count, double dt) {
+    if (!it->accelerations_valid) {
+        evaluate_accelerations(it, entities, count);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        Entity* e = &entities[i];
+        if (e->is_static) continue;
+        vec3_axpy(&e->position, dt, e->velocity);
+        vec3_axpy(&e->velocity, dt, e->acceleration);
+    }
+    it->accelerations_valid = false;
+}
+
+static void yoshida_step(Integrator* it, Entity* entities, size_t count, double dt) {
+    const double cbrt2 = cbrt(2.0);
+    const double w1 = 1.0 / (2.0 - cbrt2);
+    const double w0 = -cbrt2 / (2.0 - cbrt2);
+
+    verlet_step(it, entities, count, w1 * dt);
+    verlet_step(it, entities, count, w0 * dt);
+    verlet_step(it, entities, count, w1 * dt);
+}
+
+static void load_state(const Entity* entities, size_t count, double* y) {
+    for (size_t i = 0; i < count; i++) {
+        double* s = y + STATE_STRIDE * i;
+        s[0] = entities[i].position.x;
+        s[1] = entities[i].position.y;
+        s[2] = entities[i].position.z;
+        s[3] = entities[i].velocity.x;
+        s[4] = entities[i].velocity.y;
+        s[5] = entities[i].velocity.z;
+    }
+}
+
+static void store_state(Entity* entities, size_t count, const double* y) {
+    for (size_t i = 0; i < count; i++) {
+        if (entities[i].is_static) continue;
+        const double* s = y + STATE_STRIDE * i;
+        entities[i].position.x = s[0];
+        entities[i].position.y = s[1];
+        entities[i].position.z = s[2];
+        entities[i].velocity.x = s[3];
+        entities[i].velocity.y = s[4];
+        entities[i].velocity.z = s[5];
+    }
+}
+
+/**
+ * Derivative (velocity, acceleration) from the accelerations currently held by the entities.
+ */
+static void read_derivative(const Entity* entities, size_t count, double* k) {
+    for (size_t i = 0; i < count; i++) {
+        double* d = k + STATE_STRIDE * i;
+        if (entities[i].is_static) {
+            d[0] = d[1] = d[2] = d[3] = d[4] = d[5] = 0.0;
+            continue;
+        }
+        d[0] = entities[i].velocity.x;
+        d[1] = entities[i].velocity.y;
+        d[2] = entities[i].velocity.z;
+        d[3] = entities[i].acceleration.x;
+        d[4] = entities[i].acceleration.y;
+        d[5] = entities[i].acceleration.z;
+    }
+}
+
+static void derivative(Integrator* it, Entity* entities, size_t count, const double* y, double* k) {
+    store_state(entities, count, y);
+    evaluate_accelerations(it, entities, count);
+    read_derivative(entities, count, k);
+}
+
+static ErrorCode dormand_prince_step(Integrator* it, Entity* entities, size_t count, double dt) {
+    size_t len = STATE_STRIDE * count;
+    if (DOPRI_BUFFERS * len > it->scratch_capacity) {
+        double* scratch = realloc(it->scratch, DOPRI_BUFFERS * len * sizeof(double));
+        if (!scratch) return OPERATION_SET_FAILED;
+        it->scratch = scratch;
+        it->scratch_capacity = DOPRI_BUFFERS * len;
+    }
+
+    double* y = it->scratch;
+    double* y_stage = y + len;
+    double* k[7];
+    for (int s = 0; s < 7; s++) {
+        k[s] = y_stage + (size_t)(s + 1) * len;
+    }
+
+    load_state(entities, count, y);
+    if (!it->accelerations_valid) {
+        evaluate_accelerations(it, entities, count);
+    }
+    read_derivative(entities, count, k[0]);
+
+    double remaining = dt;
+    double h = it->dt_next > 0.0 ? it->dt_next : dt;
+    double proposal = h;
+    int rejections = 0;
+    ErrorCode rc = OPERATION_SET_SUCCESS;
+
+    while (remaining > 1e-14 * dt) {
+        if (h > it->dt_max) h = it->dt_max;
+        if (h < it->dt_min) h = it->dt_min;
+        bool truncated = remaining < h;
+        double step = truncated ? remaining : h;
+
+        for (int s = 1; s < 7; s++) {
+            for (size_t j = 0; j < len; j++) {
+                double acc = 0.0;
+                for (int m = 0; m < s; m++) acc += dp_a[s][m] * k[m][j];
+                y_stage[j] = y[j] + step * acc;
+            }
+            derivative(it, entities, count, y_stage, k[s]);
+        }
+        // y_stage now holds the 5th order solution and k[6] its derivative
+
+        double err_sum = 0.0;
+        for (size_t j = 0; j < len; j++) {
+            double e = 0.0;
+            for (int s = 0; s < 7; s++) e += dp_e[s] * k[s][j];
+            double scale = it->abs_tol + it->rel_tol * fmax(fabs(y[j]), fabs(y_stage[j]));
+            double r = step * e / scale;
+            err_sum += r * r;
+        }
+        double err = len ? sqrt(err_sum / len) : 0.0;
+        if (!isfinite(err)) {
+            // non-finite state or zero tolerances, no step size can satisfy the error test
+            rc = OPERATION_SET_FAILED;
+            break;
+        }
+
+        double factor = err > 0.0 ? 0.9 * pow(err, -0.2) : 5.0;
+        if (factor < 0.2) factor = 0.2;
+        if (factor > 5.0) factor = 5.0;
+
+        bool accepted = err <= 1.0 || step <= it->dt_min;
+        if (accepted) {
+            double* tmp = y; y = y_stage; y_stage = tmp;
+            tmp = k[0]; k[0] = k[6]; k[6] = tmp;
+            remaining -= step;
+            it->steps_accepted++;
+            rejections = 0;
+        } else {
+            it->steps_rejected++;
+            if (++rejections == DOPRI_MAX_REJECTIONS) {
+                rc = OPERATION_SET_FAILED;
+                break;
+            }
+        }
+        h = step * factor;
+        // a substep shortened to hit the end of dt says little about the step size the next call can take
+        if (!(truncated && accepted)) proposal = h;
+    }
+
+    // entities may hold a rejected stage, restore the accepted state and its accelerations
+    store_state(entities, count, y);
+    for (size_t i = 0; i < count; i++) {
+        if (entities[i].is_static) continue;
+        const double* d = k[0] + STATE_STRIDE * i;
+        entities[i].acceleration.x = d[3];
+        entities[i].acceleration.y = d[4];
+        entities[i].acceleration.z = d[5];
+    }
+    it->accelerations_valid = true;
+    it->dt_next = rc == OPERATION_SET_SUCCESS ? proposal : 0.0;
+
+    return rc;
+}
+
+ErrorCode integrator_step(Integrator* it, Entity* entities, size_t count, double dt) {
+    if (!it || !it->accelerations) {
+        return OPERATION_SET_FAILED;
+    }
+    if (!entities) {
+        return ENTITY_VOID_ERROR;
+    }
+    if (!(dt > 0.0) || !isfinite(dt)) {
+        return OPERATION_SET_FAILED;
+    }
+    if (count == 0) {
+        return OPERATION_SET_SUCCESS;
+    }
+
+    switch (it->type) {
+        case INTEGRATOR_EULER:
+            euler_step(it, entities, count, dt);
+            it->steps_accepted++;
+            break;
+        case INTEGRATOR_VELOCITY_VERLET:
+            verlet_step(it, entities, count, dt);
+            it->steps_accepted++;
+            break;
+        case INTEGRATOR_YOSHIDA4:
+            yoshida_step(it, entities, count, dt);
+            it->steps_accepted++;
+            break;
+        case INTEGRATOR_DORMAND_PRINCE:
+            return dormand_prince_step(it, entities, count, dt);
+        default:
+            return OPERATION_SET_FAILED;
+    }
+    return OPERATION_SET_SUCCESS;
+}
+
+void integrator_gravity_accelerations(Entity* entities, size_t count, void* user) {
+    (void)user;
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = i + 1; j < count; j++) {
+            apply_universal_gravitation(&entities[i], &entities[j]);
+        }
+    }
+}
+
+double gravity_system_energy(const Entity* entities, size_t count) {
+    double energy = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        const Entity* a = &entities[i];
+        energy += 0.5 * a->mass * vec3_length_sq(a->velocity);
+        for (size_t j = i + 1; j < count; j++) {
+            energy -= G * a->mass * entities[j].mass / vec3_distance(a->position, entities[j].position);
+        }
+    }
+    return energy;
+}
@@ -0,0 +1,334 @@
+#include "../../include/core/name_registry.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+#define NAME_ARENA_BLOCK (64 * 1024)
+#define NAME_INITIAL_IDS 64
+// page k of the id directory holds NAME_INITIAL_IDS << k ids, 27 pages cover every 32-bit id
+#define NAME_PAGES 27
+
+#ifdef _WIN32
+typedef SRWLOCK NameLock;
+#define NAME_ATOMIC(T) T volatile
+#define load_acquire(p) ReadPointerAcquire((PVOID const volatile*)(p))
+#define store_release(p, v) WritePointerRelease((PVOID volatile*)(p), (PVOID)(v))
+
+static bool lock_init(NameLock* l) {
+    InitializeSRWLock(l);
+    return true;
+}
+static void lock_destroy(NameLock* l) { (void)l; }
+static void lock_acquire(NameLock* l) { AcquireSRWLockExclusive(l); }
+static void lock_release(NameLock* l) { ReleaseSRWLockExclusive(l); }
+#else
+typedef pthread_mutex_t NameLock;
+#define NAME_ATOMIC(T) _Atomic(T)
+#define load_acquire(p) atomic_load_explicit(p, memory_order_acquire)
+#define store_release(p, v) atomic_store_explicit(p, v, memory_order_release)
+
+static bool lock_init(NameLock* l) { return pthread_mutex_init(l, NULL) == 0; }
+static void lock_destroy(NameLock* l) { pthread_mutex_destroy(l); }
+static void lock_acquire(NameLock* l) { pthread_mutex_lock(l); }
+static void lock_release(NameLock* l) { pthread_mutex_unlock(l); }
+#endif
+
+typedef NAME_ATOMIC(const char*) NameEntry;
+
+struct NameRegistry {
+    NameLock lock;
+
+    char** blocks;              // arena blocks, strings are stored null terminated
+    size_t block_count;
+    size_t block_capacity;
+    size_t block_used;          // bytes used in the last block
+    size_t block_size;          // size of the last block
+
+    // id -> string, pages are allocated on demand and never move so readers need no lock
+    NAME_ATOMIC(NameEntry*) pages[NAME_PAGES];
+
+    uint32_t* lengths;          // indexed by id
+    uint32_t* hashes;
+    size_t count;               // ids handed out, NAME_ID_NONE included
+    size_t capacity;
+
+    NameId* slots;              // hash table of ids, NAME_ID_NONE marks a free slot
+    size_t slot_mask;
+
+    size_t bytes;               // arena bytes holding strings
+};
+
+static NameRegistry* default_registry;
+#ifdef _WIN32
+static INIT_ONCE default_once = INIT_ONCE_STATIC_INIT;
+#else
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+#endif
+
+/**
+ * FNV-1a, 32 bit.
+ */
+static uint32_t hash_name(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static size_t page_of(size_t id, size_t* offset) {
+    size_t k = 0;
+    for (size_t v = id / NAME_INITIAL_IDS + 1; v > 1; v >>= 1) k++;
+    *offset = id - (((size_t)1 << k) - 1) * NAME_INITIAL_IDS;
+    return k;
+}
+
+static const char* entry_load(const NameRegistry* reg, size_t id) {
+    size_t offset;
+    size_t k = page_of(id, &offset);
+    if (k >= NAME_PAGES) return NULL;
+    NameEntry* page = load_acquire(&((NameRegistry*)reg)->pages[k]);
+    return page ? load_acquire(&page[offset]) : NULL;
+}
+
+// writers hold the lock, the release stores publish the page and the string to lock-free readers
+static bool entry_store(NameRegistry* reg, size_t id, const char* s) {
+    size_t offset;
+    size_t k = page_of(id, &offset);
+    NameEntry* page = load_acquire(&reg->pages[k]);
+    if (!page) {
+        page = calloc((size_t)NAME_INITIAL_IDS << k, sizeof(*page));
+        if (!page) return false;
+        store_release(&reg->pages[k], page);
+    }
+    store_release(&page[offset], s);
+    return true;
+}
+
+NameRegistry* name_registry_create(void) {
+    NameRegistry* reg = calloc(1, sizeof(*reg));
+    if (!reg) return NULL;
+
+    reg->capacity = NAME_INITIAL_IDS;
+    reg->lengths = malloc(reg->capacity * sizeof(*reg->lengths));
+    reg->hashes = malloc(reg->capacity * sizeof(*reg->hashes));
+    reg->slot_mask = reg->capacity * 2 - 1;
+    reg->slots = calloc(reg->slot_mask + 1, sizeof(*reg->slots));
+    bool locked = lock_init(&reg->lock);
+    if (!reg->lengths || !reg->hashes || !reg->slots || !locked || !entry_store(reg, NAME_ID_NONE, "")) {
+        if (locked) lock_destroy(&reg->lock);
+        free((void*)reg->pages[0]);
+        free(reg->lengths);
+        free(reg->hashes);
+        free(reg->slots);
+        free(reg);
+        return NULL;
+    }
+
+    // id 0 is the empty name, it is never placed in the hash table
+    reg->lengths[NAME_ID_NONE] = 0;
+    reg->hashes[NAME_ID_NONE] = 0;
+    reg->count = 1;
+    return reg;
+}
+
+void name_registry_destroy(NameRegistry* reg) {
+    if (!reg) return;
+    for (size_t i = 0; i < reg->block_count; i++) {
+        free(reg->blocks[i]);
+    }
+    for (int k = 0; k < NAME_PAGES; k++) {
+        free((void*)reg->pages[k]);
+    }
+    free(reg->blocks);
+    free(reg->lengths);
+    free(reg->hashes);
+    free(reg->slots);
+    lock_destroy(&reg->lock);
+    free(reg);
+}
+
+/**
+ * Slot holding name, or the free slot where it would be inserted.
+ */
+static size_t probe(const NameRegistry* reg, const char* name, size_t len, uint32_t hash) {
+    size_t i = hash & reg->slot_mask;
+    for (;;) {
+        NameId id = reg->slots[i];
+        if (id == NAME_ID_NONE) return i;
+        if (reg->hashes[id] == hash && reg->lengths[id] == len && memcmp(entry_load(reg, id), name, len) == 0) {
+            return i;
+        }
+        i = (i + 1) & reg->slot_mask;
+    }
+}
+
+static bool grow_table(NameRegistry* reg) {
+    size_t slot_count = (reg->slot_mask + 1) * 2;
+    NameId* slots = calloc(slot_count, sizeof(*slots));
+    if (!slots) return false;
+
+    size_t mask = slot_count - 1;
+    for (size_t id = 1; id < reg->count; id++) {
+        size_t i = reg->hashes[id] & mask;
+        while (slots[i] != NAME_ID_NONE) i = (i + 1) & mask;
+        slots[i] = (NameId)id;
+    }
+    free(reg->slots);
+    reg->slots = slots;
+    reg->slot_mask = mask;
+    return true;
+}
+
+static bool grow_ids(NameRegistry* reg) {
+    size_t capacity = reg->capacity * 2;
+    uint32_t* lengths = realloc(reg->lengths, capacity * sizeof(*lengths));
+    if (!lengths) return false;
+    reg->lengths = lengths;
+    uint32_t* hashes = realloc(reg->hashes, capacity * sizeof(*hashes));
+    if (!hashes) return false;
+    reg->hashes = hashes;
+    reg->capacity = capacity;
+    return true;
+}
+
+/**
+ * Copy a string into the arena, opening a new block when the last one is full.
+ */
+static const char* arena_copy(NameRegistry* reg, const char* name, size_t len) {
+    if (reg->block_count == 0 || reg->block_size - reg->block_used < len + 1) {
+        if (reg->block_count == reg->block_capacity) {
+            size_t capacity = reg->block_capacity ? reg->block_capacity * 2 : 16;
+            char** blocks = realloc(reg->blocks, capacity * sizeof(*blocks));
+            if (!blocks) return NULL;
+            reg->blocks = blocks;
+            reg->block_capacity = capacity;
+        }
+        size_t size = len + 1 > NAME_ARENA_BLOCK ? len + 1 : NAME_ARENA_BLOCK;
+        char* block = malloc(size);
+        if (!block) return NULL;
+        reg->blocks[reg->block_count++] = block;
+        reg->block_size = size;
+        reg->block_used = 0;
+    }
+
+    char* p = reg->blocks[reg->block_count - 1] + reg->block_used;
+    memcpy(p, name, len);
+    p[len] = '\0';
+    reg->block_used += len + 1;
+    reg->bytes += len + 1;
+    return p;
+}
+
+static NameRegistryErrorCode intern_locked(NameRegistry* reg, const char* name, size_t len, uint32_t hash,
+                                           NameId* id) {
+    size_t slot = probe(reg, name, len, hash);
+    if (reg->slots[slot] != NAME_ID_NONE) {
+        *id = reg->slots[slot];
+        return NAME_REGISTRY_SUCCESS;
+    }
+
+    if (reg->count > UINT32_MAX || len > UINT32_MAX) return NAME_REGISTRY_ERROR_FULL;
+    if (reg->count == reg->capacity && !grow_ids(reg)) return NAME_REGISTRY_ERROR_OUT_OF_MEMORY;
+
+    // keep the table at most half full so probe sequences stay short
+    if ((reg->count + 1) * 2 > reg->slot_mask + 1) {
+        if (!grow_table(reg)) return NAME_REGISTRY_ERROR_OUT_OF_MEMORY;
+        slot = probe(reg, name, len, hash);
+    }
+
+    const char* copy = arena_copy(reg, name, len);
+    if (!copy) return NAME_REGISTRY_ERROR_OUT_OF_MEMORY;
+
+    NameId new_id = (NameId)reg->count;
+    if (!entry_store(reg, new_id, copy)) return NAME_REGISTRY_ERROR_OUT_OF_MEMORY;
+    reg->count++;
+    reg->lengths[new_id] = (uint32_t)len;
+    reg->hashes[new_id] = hash;
+    reg->slots[slot] = new_id;
+
+    *id = new_id;
+    return NAME_REGISTRY_SUCCESS;
+}
+
+NameRegistryErrorCode name_registry_intern_n(NameRegistry* reg, const char* name, size_t len, NameId* id) {
+    if (!reg || !id) return NAME_REGISTRY_ERROR_NULL_POINTER;
+    if (!name || len == 0) {
+        *id = NAME_ID_NONE;
+        return NAME_REGISTRY_SUCCESS;
+    }
+
+    // hashing happens outside the lock, only the probe and insert are serialised
+    uint32_t hash = hash_name(name, len);
+    lock_acquire(&reg->lock);
+    NameRegistryErrorCode rc = intern_locked(reg, name, len, hash, id);
+    lock_release(&reg->lock);
+    return rc;
+}
+
+NameRegistryErrorCode name_registry_intern(NameRegistry* reg, const char* name, NameId* id) {
+    return name_registry_intern_n(reg, name, name ? strlen(name) : 0, id);
+}
+
+NameRegistryErrorCode name_registry_find(NameRegistry* reg, const char* name, NameId* id) {
+    if (!reg || !name || !id) return NAME_REGISTRY_ERROR_NULL_POINTER;
+
+    size_t len = strlen(name);
+    if (len == 0) {
+        *id = NAME_ID_NONE;
+        return NAME_REGISTRY_SUCCESS;
+    }
+
+    uint32_t hash = hash_name(name, len);
+    lock_acquire(&reg->lock);
+    NameId found = reg->slots[probe(reg, name, len, hash)];
+    lock_release(&reg->lock);
+
+    if (found == NAME_ID_NONE) return NAME_REGISTRY_ERROR_NOT_FOUND;
+    *id = found;
+    return NAME_REGISTRY_SUCCESS;
+}
+
+const char* name_registry_str(NameRegistry* reg, NameId id) {
+    if (!reg) return "";
+    // ids that were never handed out read a NULL entry or an unallocated page
+    const char* s = entry_load(reg, id);
+    return s ? s : "";
+}
+
+size_t name_registry_count(NameRegistry* reg) {
+    if (!reg) return 0;
+    lock_acquire(&reg->lock);
+    size_t n = reg->count;
+    lock_release(&reg->lock);
+    return n;
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK init_default(PINIT_ONCE once, PVOID param, PVOID* context) {
+    (void)once; (void)param; (void)context;
+    default_registry = name_registry_create();
+    return TRUE;
+}
+
+NameRegistry* name_registry_default(void) {
+    InitOnceExecuteOnce(&default_once, init_default, NULL, NULL);
+    return default_registry;
+}
+#else
+static void init_default(void) {
+    default_registry = name_registry_create();
+}
+
+NameRegistry* name_registry_default(void) {
+    pthread_once(&default_once, init_default);
+    return default_registry;
+}
+#endif
@@ -0,0 +1,627 @@
+#include "../../include/core/narrowphase.h"
+#include "../../include/mathlib/vec_math.h"
+#include <stdlib.h>
+
+// gathered geometry per body
+enum { SPHERE_X, SPHERE_Y, SPHERE_Z, SPHERE_R, SPHERE_FIELDS };
+enum {
+    BOX_X, BOX_Y, BOX_Z,
+    BOX_U0X, BOX_U0Y, BOX_U0Z,
+    BOX_U1X, BOX_U1Y, BOX_U1Z,
+    BOX_U2X, BOX_U2Y, BOX_U2Z,
+    BOX_H0, BOX_H1, BOX_H2,
+    BOX_FIELDS
+};
+enum {
+    CYL_X, CYL_Y, CYL_Z,
+    CYL_UX, CYL_UY, CYL_UZ,     // axis
+    CYL_EX, CYL_EY, CYL_EZ,     // any direction perpendicular to the axis
+    CYL_R, CYL_H,               // radius, half height
+    CYL_FIELDS
+};
+// contact outputs, stored after the geometry of both bodies
+enum { OUT_PX, OUT_PY, OUT_PZ, OUT_NX, OUT_NY, OUT_NZ, OUT_DEPTH, OUT_FIELDS };
+
+static const size_t body_fields[CONTACT_PAIR_COUNT][2] = {
+    {SPHERE_FIELDS, SPHERE_FIELDS},
+    {SPHERE_FIELDS, BOX_FIELDS},
+    {SPHERE_FIELDS, CYL_FIELDS},
+    {BOX_FIELDS, BOX_FIELDS}
+};
+
+#define PAIR_FIELDS(t) (body_fields[t][0] + body_fields[t][1])
+#define COLUMN(batch, f) ((batch)->columns + (size_t)(f) * (batch)->capacity)
+
+static const double EPS2 = 1e-24;
+
+// fmin/fmax keep NaN semantics and do not vectorise, a plain select does
+static inline double clamp(double v, double lo, double hi) {
+    v = v < lo ? lo : v;
+    return v > hi ? hi : v;
+}
+
+NarrowPhaseErrorCode narrowphase_init(NarrowPhase* np) {
+    if (!np) return NARROWPHASE_ERROR_NULL_POINTER;
+    memset(np, 0, sizeof(*np));
+    return NARROWPHASE_SUCCESS;
+}
+
+void narrowphase_free(NarrowPhase* np) {
+    if (!np) return;
+    for (int t = 0; t < CONTACT_PAIR_COUNT; t++) {
+        free(np->batches[t].columns);
+        free(np->batches[t].pair);
+        free(np->batches[t].swapped);
+    }
+    free(np->contacts);
+    memset(np, 0, sizeof(*np));
+}
+
+void narrowphase_clear(NarrowPhase* np) {
+    if (!np) return;
+    for (int t = 0; t < CONTACT_PAIR_COUNT; t++) {
+        np->batches[t].count = 0;
+    }
+    np->pair_count = 0;
+}
+
+static bool batch_reserve(ContactBatch* b, size_t fields, size_t needed) {
+    if (needed <= b->capacity) return true;
+    size_t capacity = b->capacity ? 2 * b->capacity : 64;
+    while (capacity < needed) capacity *= 2;
+
+    double* columns = malloc(fields * capacity * sizeof(double));
+    size_t* pair = realloc(b->pair, capacity * sizeof(size_t));
+    if (pair) b->pair = pair;
+    unsigned char* swapped = realloc(b->swapped, capacity);
+    if (swapped) b->swapped = swapped;
+    if (!columns || !pair || !swapped) {
+        free(columns);
+        return false;
+    }
+
+    // columns are strided by capacity, move each one to its new offset
+    for (size_t f = 0; f < fields && b->columns; f++) {
+        memcpy(columns + f * capacity, b->columns + f * b->capacity, b->count * sizeof(double));
+    }
+    free(b->columns);
+    b->columns = columns;
+    b->capacity = capacity;
+    return true;
+}
+
+static void gather_sphere(ContactBatch* b, size_t base, size_t i, const Entity* e, double radius) {
+    COLUMN(b, base + SPHERE_X)[i] = e->position.x;
+    COLUMN(b, base + SPHERE_Y)[i] = e->position.y;
+    COLUMN(b, base + SPHERE_Z)[i] = e->position.z;
+    COLUMN(b, base + SPHERE_R)[i] = radius;
+}
+
+// quat_rotate needs a unit quaternion, the stored one may have drifted
+static void unit_orientation(const Entity* e, double q[4]) {
+    memcpy(q, e->quaternion, 4 * sizeof(double));
+    quat_normalize(q);
+}
+
+static void gather_box(ContactBatch* b, size_t base, size_t i, const Entity* e, const SceneShape* s) {
+    double q[4];
+    unit_orientation(e, q);
+    Vector u0 = quat_rotate(q, vec3(1.0, 0.0, 0.0));
+    Vector u1 = quat_rotate(q, vec3(0.0, 1.0, 0.0));
+    Vector u2 = quat_rotate(q, vec3(0.0, 0.0, 1.0));
+    COLUMN(b, base + BOX_X)[i] = e->position.x;
+    COLUMN(b, base + BOX_Y)[i] = e->position.y;
+    COLUMN(b, base + BOX_Z)[i] = e->position.z;
+    COLUMN(b, base + BOX_U0X)[i] = u0.x;
+    COLUMN(b, base + BOX_U0Y)[i] = u0.y;
+    COLUMN(b, base + BOX_U0Z)[i] = u0.z;
+    COLUMN(b, base + BOX_U1X)[i] = u1.x;
+    COLUMN(b, base + BOX_U1Y)[i] = u1.y;
+    COLUMN(b, base + BOX_U1Z)[i] = u1.z;
+    COLUMN(b, base + BOX_U2X)[i] = u2.x;
+    COLUMN(b, base + BOX_U2Y)[i] = u2.y;
+    COLUMN(b, base + BOX_U2Z)[i] = u2.z;
+    COLUMN(b, base + BOX_H0)[i] = 0.5 * s->width;
+    COLUMN(b, base + BOX_H1)[i] = 0.5 * s->height;
+    COLUMN(b, base + BOX_H2)[i] = 0.5 * s->width;
+}
+
+static void gather_cylinder(ContactBatch* b, size_t base, size_t i, const Entity* e, const SceneShape* s) {
+    double q[4];
+    unit_orientation(e, q);
+    Vector u = quat_rotate(q, vec3(0.0, 1.0, 0.0));
+    Vector p = quat_rotate(q, vec3(1.0, 0.0, 0.0));
+    COLUMN(b, base + CYL_X)[i] = e->position.x;
+    COLUMN(b, base + CYL_Y)[i] = e->position.y;
+    COLUMN(b, base + CYL_Z)[i] = e->position.z;
+    COLUMN(b, base + CYL_UX)[i] = u.x;
+    COLUMN(b, base + CYL_UY)[i] = u.y;
+    COLUMN(b, base + CYL_UZ)[i] = u.z;
+    COLUMN(b, base + CYL_EX)[i] = p.x;
+    COLUMN(b, base + CYL_EY)[i] = p.y;
+    COLUMN(b, base + CYL_EZ)[i] = p.z;
+    COLUMN(b, base + CYL_R)[i] = s->radius;
+    COLUMN(b, base + CYL_H)[i] = 0.5 * s->height;
+}
+
+static int shape_rank(ShapeType t) {
+    switch (t) {
+        case SHAPE_POINT:
+        case SHAPE_SPHERE: return 0;
+        case SHAPE_CUBE: return 1;
+        case SHAPE_CYLINDER: return 2;
+        default: return -1;
+    }
+}
+
+/**
+ * Pair type of two shapes, spheres before boxes before cylinders. Returns -1 for unsupported combinations.
+ */
+static int classify_pair(const SceneShape* a, const SceneShape* b, bool* swapped) {
+    int ra = shape_rank(a->type), rb = shape_rank(b->type);
+    *swapped = ra > rb;
+    if (*swapped) {
+        int t = ra; ra = rb; rb = t;
+    }
+    if (ra == 0 && rb == 0) return CONTACT_SPHERE_SPHERE;
+    if (ra == 0 && rb == 1) return CONTACT_SPHERE_BOX;
+    if (ra == 0 && rb == 2) return CONTACT_SPHERE_CYLINDER;
+    if (ra == 1 && rb == 1) return CONTACT_BOX_BOX;
+    return -1;
+}
+
+static double sphere_radius(const SceneShape* s) {
+    return s->type == SHAPE_POINT ? 0.0 : s->radius;
+}
+
+static void gather_pair(ContactBatch* batch, ContactPairType type, size_t i,
+                        const Entity* a, const SceneShape* shape_a, const Entity* b, const SceneShape* shape_b) {
+    size_t second = body_fields[type][0];
+    switch (type) {
+        case CONTACT_SPHERE_SPHERE:
+            gather_sphere(batch, 0, i, a, sphere_radius(shape_a));
+            gather_sphere(batch, second, i, b, sphere_radius(shape_b));
+            break;
+        case CONTACT_SPHERE_BOX:
+            gather_sphere(batch, 0, i, a, sphere_radius(shape_a));
+            gather_box(batch, second, i, b, shape_b);
+            break;
+        case CONTACT_SPHERE_CYLINDER:
+            gather_sphere(batch, 0, i, a, sphere_radius(shape_a));
+            gather_cylinder(batch, second, i, b, shape_b);
+            break;
+        case CONTACT_BOX_BOX:
+            gather_box(batch, 0, i, a, shape_a);
+            gather_box(batch, second, i, b, shape_b);
+            break;
+        default:
+            break;
+    }
+}
+
+NarrowPhaseErrorCode narrowphase_add(NarrowPhase* np, const Entity* a, const SceneShape* shape_a,
+                                     const Entity* b, const SceneShape* shape_b, size_t* pair_index) {
+    if (!np || !a || !b || !shape_a || !shape_b) return NARROWPHASE_ERROR_NULL_POINTER;
+
+    bool swapped;
+    int type = classify_pair(shape_a, shape_b, &swapped);
+    if (type < 0) return NARROWPHASE_ERROR_UNSUPPORTED_PAIR;
+
+    if (np->pair_count == np->pair_capacity) {
+        size_t capacity = np->pair_capacity ? 2 * np->pair_capacity : 64;
+        Contact* contacts = realloc(np->contacts, capacity * sizeof(Contact));
+        if (!contacts) return NARROWPHASE_ERROR_OUT_OF_MEMORY;
+        np->contacts = contacts;
+        np->pair_capacity = capacity;
+    }
+
+    ContactBatch* batch = &np->batches[type];
+    if (!batch_reserve(batch, PAIR_FIELDS(type) + OUT_FIELDS, batch->count + 1)) {
+        return NARROWPHASE_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t i = batch->count;
+    if (swapped) {
+        gather_pair(batch, (ContactPairType)type, i, b, shape_b, a, shape_a);
+    } else {
+        gather_pair(batch, (ContactPairType)type, i, a, shape_a, b, shape_b);
+    }
+    batch->pair[i] = np->pair_count;
+    batch->swapped[i] = swapped;
+    batch->count++;
+    if (pair_index) *pair_index = np->pair_count;
+    np->pair_count++;
+    return NARROWPHASE_SUCCESS;
+}
+
+/* ---------- kernels, one pass over the columns of a batch each ---------- */
+
+static void sphere_sphere_kernel(ContactBatch* batch) {
+    const size_t n = batch->count;
+    const double* restrict ax = COLUMN(batch, SPHERE_X);
+    const double* restrict ay = COLUMN(batch, SPHERE_Y);
+    const double* restrict az = COLUMN(batch, SPHERE_Z);
+    const double* restrict ar = COLUMN(batch, SPHERE_R);
+    const double* restrict bx = COLUMN(batch, SPHERE_FIELDS + SPHERE_X);
+    const double* restrict by = COLUMN(batch, SPHERE_FIELDS + SPHERE_Y);
+    const double* restrict bz = COLUMN(batch, SPHERE_FIELDS + SPHERE_Z);
+    const double* restrict br = COLUMN(batch, SPHERE_FIELDS + SPHERE_R);
+    const size_t out = 2 * SPHERE_FIELDS;
+    double* restrict px = COLUMN(batch, out + OUT_PX);
+    double* restrict py = COLUMN(batch, out + OUT_PY);
+    double* restrict pz = COLUMN(batch, out + OUT_PZ);
+    double* restrict nx = COLUMN(batch, out + OUT_NX);
+    double* restrict ny = COLUMN(batch, out + OUT_NY);
+    double* restrict nz = COLUMN(batch, out + OUT_NZ);
+    double* restrict depth = COLUMN(batch, out + OUT_DEPTH);
+
+    #pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+        double dx = bx[i] - ax[i], dy = by[i] - ay[i], dz = bz[i] - az[i];
+        double d2 = dx*dx + dy*dy + dz*dz;
+        double apart = (double)(d2 > EPS2);
+        // concentric spheres get the x axis as normal
+        double inv = apart * vm_rsqrt(d2 + (1.0 - apart));
+        double ux = dx * inv + (1.0 - apart), uy = dy * inv, uz = dz * inv;
+        double d = ar[i] + br[i] - d2 * inv;
+        double s = ar[i] - 0.5 * d;
+        nx[i] = ux; ny[i] = uy; nz[i] = uz;
+        depth[i] = d;
+        px[i] = ax[i] + s * ux;
+        py[i] = ay[i] + s * uy;
+        pz[i] = az[i] + s * uz;
+    }
+}
+
+static void sphere_box_kernel(ContactBatch* batch) {
+    const size_t n = batch->count;
+    const double* restrict sx = COLUMN(batch, SPHERE_X);
+    const double* restrict sy = COLUMN(batch, SPHERE_Y);
+    const double* restrict sz = COLUMN(batch, SPHERE_Z);
+    const double* restrict sr = COLUMN(batch, SPHERE_R);
+    const double* restrict bx[BOX_FIELDS];
+    for (int f = 0; f < BOX_FIELDS; f++) bx[f] = COLUMN(batch, SPHERE_FIELDS + f);
+    const size_t out = SPHERE_FIELDS + BOX_FIELDS;
+    double* restrict px = COLUMN(batch, out + OUT_PX);
+    double* restrict py = COLUMN(batch, out + OUT_PY);
+    double* restrict pz = COLUMN(batch, out + OUT_PZ);
+    double* restrict nx = COLUMN(batch, out + OUT_NX);
+    double* restrict ny = COLUMN(batch, out + OUT_NY);
+    double* restrict nz = COLUMN(batch, out + OUT_NZ);
+    double* restrict depth = COLUMN(batch, out + OUT_DEPTH);
+
+    #pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+        Vector s = vec3(sx[i], sy[i], sz[i]);
+        Vector c = vec3(bx[BOX_X][i], bx[BOX_Y][i], bx[BOX_Z][i]);
+        Vector u0 = vec3(bx[BOX_U0X][i], bx[BOX_U0Y][i], bx[BOX_U0Z][i]);
+        Vector u1 = vec3(bx[BOX_U1X][i], bx[BOX_U1Y][i], bx[BOX_U1Z][i]);
+        Vector u2 = vec3(bx[BOX_U2X][i], bx[BOX_U2Y][i], bx[BOX_U2Z][i]);
+        double h0 = bx[BOX_H0][i], h1 = bx[BOX_H1][i], h2 = bx[BOX_H2][i];
+
+        Vector r = vec3_sub(s, c);
+        double p0 = vec3_dot(r, u0), p1 = vec3_dot(r, u1), p2 = vec3_dot(r, u2);
+
+        // centre outside: closest point on the box
+        double q0 = clamp(p0, -h0, h0);
+        double q1 = clamp(p1, -h1, h1);
+        double q2 = clamp(p2, -h2, h2);
+        Vector closest = vec3_madd(vec3_madd(vec3_madd(c, q0, u0), q1, u1), q2, u2);
+        Vector d = vec3_sub(s, closest);
+        double d2 = vec3_length_sq(d);
+        double outside = (double)(d2 > EPS2);
+        double inv = outside * vm_rsqrt(d2 + (1.0 - outside));
+        Vector n_out = vec3_scale(d, inv);
+        double depth_out = sr[i] - d2 * inv;
+
+        // centre inside: push out through the nearest face
+        double pen0 = h0 - fabs(p0), pen1 = h1 - fabs(p1), pen2 = h2 - fabs(p2);
+        double k0 = pen0 <= pen1 && pen0 <= pen2 ? 1.0 : 0.0;
+        double k1 = (1.0 - k0) * (pen1 <= pen2 ? 1.0 : 0.0);
+        double k2 = 1.0 - k0 - k1;
+        double pen = k0 * pen0 + k1 * pen1 + k2 * pen2;
+        Vector n_in = vec3_scale(u0, k0 * copysign(1.0, p0));
+        n_in = vec3_madd(n_in, k1 * copysign(1.0, p1), u1);
+        n_in = vec3_madd(n_in, k2 * copysign(1.0, p2), u2);
+        double depth_in = sr[i] + pen;
+
+        // normal from the box towards the sphere, flipped so it points sphere -> box
+        Vector normal = vec3_neg(vec3_add(vec3_scale(n_out, outside), vec3_scale(n_in, 1.0 - outside)));
+        double dep = outside * depth_out + (1.0 - outside) * depth_in;
+        Vector p = vec3_madd(s, sr[i] - 0.5 * dep, normal);
+
+        nx[i] = normal.x; ny[i] = normal.y; nz[i] = normal.z;
+        depth[i] = dep;
+        px[i] = p.x; py[i] = p.y; pz[i] = p.z;
+    }
+}
+
+static void sphere_cylinder_kernel(ContactBatch* batch) {
+    const size_t n = batch->count;
+    const double* restrict sx = COLUMN(batch, SPHERE_X);
+    const double* restrict sy = COLUMN(batch, SPHERE_Y);
+    const double* restrict sz = COLUMN(batch, SPHERE_Z);
+    const double* restrict sr = COLUMN(batch, SPHERE_R);
+    const double* restrict cy[CYL_FIELDS];
+    for (int f = 0; f < CYL_FIELDS; f++) cy[f] = COLUMN(batch, SPHERE_FIELDS + f);
+    const size_t out = SPHERE_FIELDS + CYL_FIELDS;
+    double* restrict px = COLUMN(batch, out + OUT_PX);
+    double* restrict py = COLUMN(batch, out + OUT_PY);
+    double* restrict pz = COLUMN(batch, out + OUT_PZ);
+    double* restrict nx = COLUMN(batch, out + OUT_NX);
+    double* restrict ny = COLUMN(batch, out + OUT_NY);
+    double* restrict nz = COLUMN(batch, out + OUT_NZ);
+    double* restrict depth = COLUMN(batch, out + OUT_DEPTH);
+
+    #pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+        Vector s = vec3(sx[i], sy[i], sz[i]);
+        Vector c = vec3(cy[CYL_X][i], cy[CYL_Y][i], cy[CYL_Z][i]);
+        Vector u = vec3(cy[CYL_UX][i], cy[CYL_UY][i], cy[CYL_UZ][i]);
+        Vector e_default = vec3(cy[CYL_EX][i], cy[CYL_EY][i], cy[CYL_EZ][i]);
+        double radius = cy[CYL_R][i], half = cy[CYL_H][i];
+
+        Vector r = vec3_sub(s, c);
+        double along = vec3_dot(r, u);
+        Vector radial = vec3_madd(r, -along, u);
+        double rd2 = vec3_length_sq(radial);
+        double off_axis = (double)(rd2 > EPS2);
+        double inv_rd = off_axis * vm_rsqrt(rd2 + (1.0 - off_axis));
+        // on the axis any perpendicular direction will do
+        Vector e = vec3_add(vec3_scale(radial, inv_rd), vec3_scale(e_default, 1.0 - off_axis));
+        double rd = rd2 * inv_rd;
+
+        // centre outside: closest point on the solid cylinder
+        double along_c = clamp(along, -half, half);
+        double rd_c = rd < radius ? rd : radius;
+        Vector closest = vec3_madd(vec3_madd(c, along_c, u), rd_c, e);
+        Vector d = vec3_sub(s, closest);
+        double d2 = vec3_length_sq(d);
+        double outside = (double)(d2 > EPS2);
+        double inv = outside * vm_rsqrt(d2 + (1.0 - outside));
+        Vector n_out = vec3_scale(d, inv);
+        double depth_out = sr[i] - d2 * inv;
+
+        // centre inside: leave through the side or the nearer cap
+        double pen_side = radius - rd, pen_cap = half - fabs(along);
+        double side = (double)(pen_side < pen_cap);
+        Vector n_in = vec3_add(vec3_scale(e, side), vec3_scale(u, (1.0 - side) * copysign(1.0, along)));
+        double depth_in = sr[i] + side * pen_side + (1.0 - side) * pen_cap;
+
+        Vector normal = vec3_neg(vec3_add(vec3_scale(n_out, outside), vec3_scale(n_in, 1.0 - outside)));
+        double dep = outside * depth_out + (1.0 - outside) * depth_in;
+        Vector p = vec3_madd(s, sr[i] - 0.5 * dep, normal);
+
+        nx[i] = normal.x; ny[i] = normal.y; nz[i] = normal.z;
+        depth[i] = dep;
+        px[i] = p.x; py[i] = p.y; pz[i] = p.z;
+    }
+}
+
+static inline double sign_of(double v) {
+    return copysign(1.0, v);
+}
+
+// one of three vectors or values by a lane-wise index, as selects instead of an indexed load
+static inline Vector pick_vector(double k, Vector v0, Vector v1, Vector v2) {
+    return vec3(k == 0.0 ? v0.x : (k == 1.0 ? v1.x : v2.x),
+                k == 0.0 ? v0.y : (k == 1.0 ? v1.y : v2.y),
+                k == 0.0 ? v0.z : (k == 1.0 ? v1.z : v2.z));
+}
+
+static inline double pick_value(double k, double v0, double v1, double v2) {
+    return k == 0.0 ? v0 : (k == 1.0 ? v1 : v2);
+}
+
+// projected half extent of a box onto the unit axis l
+static inline double box_extent(Vector l, Vector u0, Vector u1, Vector u2, double h0, double h1, double h2) {
+    return h0 * fabs(vec3_dot(u0, l)) + h1 * fabs(vec3_dot(u1, l)) + h2 * fabs(vec3_dot(u2, l));
+}
+
+/**
+ * Least overlapping separating axis so far. kind is 0 for a face of a, 1 for a face of b and 2 for an edge pair;
+ * edge_a/edge_b are the indices of the two edge directions. All fields are updated with selects.
+ */
+typedef struct SatAxis {
+    double overlap;
+    Vector axis;
+    double kind;
+    double edge_a;
+    double edge_b;
+} SatAxis;
+
+static inline void sat_consider(SatAxis* best, double overlap, double score, Vector axis, double dist,
+                                double kind, double edge_a, double edge_b) {
+    bool take = score < best->overlap;
+    double s = sign_of(dist);
+    best->overlap = take ? overlap : best->overlap;
+    best->axis.x = take ? s * axis.x : best->axis.x;
+    best->axis.y = take ? s * axis.y : best->axis.y;
+    best->axis.z = take ? s * axis.z : best->axis.z;
+    best->kind = take ? kind : best->kind;
+    best->edge_a = take ? edge_a : best->edge_a;
+    best->edge_b = take ? edge_b : best->edge_b;
+}
+
+static inline void sat_face(SatAxis* best, Vector t, Vector axis, double own_half, double other_extent, double kind) {
+    double dist = vec3_dot(t, axis);
+    double overlap = own_half + other_extent - fabs(dist);
+    sat_consider(best, overlap, overlap, axis, dist, kind, 0.0, 0.0);
+}
+
+// edge axes must beat the best face axis by 5% so resting boxes keep a stable normal; parallel edges give no axis
+static inline void sat_edge(SatAxis* best, Vector t, Vector ea, Vector eb, double ia, double ib,
+                            Vector a0, Vector a1, Vector a2, double ha0, double ha1, double ha2,
+                            Vector b0, Vector b1, Vector b2, double hb0, double hb1, double hb2) {
+    Vector l = vec3_cross(ea, eb);
+    double len2 = vec3_length_sq(l);
+    double valid = (double)(len2 > 1e-18);
+    l = vec3_scale(l, valid * vm_rsqrt(len2 + (1.0 - valid)));
+    double dist = vec3_dot(t, l);
+    double overlap = box_extent(l, a0, a1, a2, ha0, ha1, ha2) + box_extent(l, b0, b1, b2, hb0, hb1, hb2) - fabs(dist);
+    double score = valid > 0.0 ? 1.05 * overlap + 1e-9 : INFINITY;
+    sat_consider(best, overlap, score, l, dist, 2.0, ia, ib);
+}
+
+/**
+ * Separating axis test of two oriented boxes over the 3 + 3 face and 9 edge axes. The contact point is the
+ * deepest vertex of the incident box (face axes) or the midpoint between the two closest edges (edge axes).
+ * Branch free, so box_box_kernel vectorises across pairs.
+ */
+static inline Contact box_box_contact(Vector ca, Vector a0, Vector a1, Vector a2, double ha0, double ha1, double ha2,
+                                      Vector cb, Vector b0, Vector b1, Vector b2, double hb0, double hb1, double hb2) {
+    Vector t = vec3_sub(cb, ca);
+    SatAxis best = {INFINITY, a0, 0.0, 0.0, 0.0};
+    // face extents are padded by 1e-12 per box axis so exactly parallel faces do not tie on rounding noise
+    double pad_a = 1e-12 * (ha0 + ha1 + ha2), pad_b = 1e-12 * (hb0 + hb1 + hb2);
+
+    sat_face(&best, t, a0, ha0, box_extent(a0, b0, b1, b2, hb0, hb1, hb2) + pad_b, 0.0);
+    sat_face(&best, t, a1, ha1, box_extent(a1, b0, b1, b2, hb0, hb1, hb2) + pad_b, 0.0);
+    sat_face(&best, t, a2, ha2, box_extent(a2, b0, b1, b2, hb0, hb1, hb2) + pad_b, 0.0);
+    sat_face(&best, t, b0, hb0, box_extent(b0, a0, a1, a2, ha0, ha1, ha2) + pad_a, 1.0);
+    sat_face(&best, t, b1, hb1, box_extent(b1, a0, a1, a2, ha0, ha1, ha2) + pad_a, 1.0);
+    sat_face(&best, t, b2, hb2, box_extent(b2, a0, a1, a2, ha0, ha1, ha2) + pad_a, 1.0);
+
+    sat_edge(&best, t, a0, b0, 0.0, 0.0, a0, a1, a2, ha0, ha1, ha2, b0, b1, b2, hb0, hb1, hb2);
+    sat_edge(&best, t, a0, b1, 0.0, 1.0, a0, a1, a2, ha0, ha1, ha2, b0, b1, b2, hb0, hb1, hb2);
+    sat_edge(&best, t, a0, b2, 0.0, 2.0, a0, a1, a2, ha0, ha1, ha2, b0, b1, b2, hb0, hb1, hb2);
+    sat_edge(&best, t, a1, b0, 1.0, 0.0, a0, a1, a2, ha0, ha1, ha2, b0, b1, b2, hb0, hb1, hb2);
+    sat_edge(&best, t, a1, b1, 1.0, 1.0, a0, a1, a2, ha0, ha1, ha2, b0, b1, b2, hb0, hb1, hb2);
+    sat_edge(&best, t, a1, b2, 1.0, 2.0, a0, a1, a2, ha0, ha1, ha2, b0, b1, b2, hb0, hb1, hb2);
+    sat_edge(&best, t, a2, b0, 2.0, 0.0, a0, a1, a2, ha0, ha1, ha2, b0, b1, b2, hb0, hb1, hb2);
+    sat_edge(&best, t, a2, b1, 2.0, 1.0, a0, a1, a2, ha0, ha1, ha2, b0, b1, b2, hb0, hb1, hb2);
+    sat_edge(&best, t, a2, b2, 2.0, 2.0, a0, a1, a2, ha0, ha1, ha2, b0, b1, b2, hb0, hb1, hb2);
+
+    Vector n = best.axis;
+    double face_a = (double)(best.kind == 0.0), face_b = (double)(best.kind == 1.0);
+    double edge = (double)(best.kind == 2.0);
+
+    // deepest vertex of b towards a, and of a towards b; on an edge axis the edge's own direction is left free
+    double kb0 = 1.0 - edge * (double)(best.edge_b == 0.0);
+    double kb1 = 1.0 - edge * (double)(best.edge_b == 1.0);
+    double kb2 = 1.0 - edge * (double)(best.edge_b == 2.0);
+    double ka0 = 1.0 - edge * (double)(best.edge_a == 0.0);
+    double ka1 = 1.0 - edge * (double)(best.edge_a == 1.0);
+    double ka2 = 1.0 - edge * (double)(best.edge_a == 2.0);
+    Vector vb = vec3_madd(cb, -kb0 * hb0 * sign_of(vec3_dot(b0, n)), b0);
+    vb = vec3_madd(vb, -kb1 * hb1 * sign_of(vec3_dot(b1, n)), b1);
+    vb = vec3_madd(vb, -kb2 * hb2 * sign_of(vec3_dot(b2, n)), b2);
+    Vector va = vec3_madd(ca, ka0 * ha0 * sign_of(vec3_dot(a0, n)), a0);
+    va = vec3_madd(va, ka1 * ha1 * sign_of(vec3_dot(a1, n)), a1);
+    va = vec3_madd(va, ka2 * ha2 * sign_of(vec3_dot(a2, n)), a2);
+
+    // closest points between the edge through va along da and the edge through vb along db
+    Vector da = pick_vector(best.edge_a, a0, a1, a2), db = pick_vector(best.edge_b, b0, b1, b2);
+    double hda = pick_value(best.edge_a, ha0, ha1, ha2), hdb = pick_value(best.edge_b, hb0, hb1, hb2);
+    Vector w = vec3_sub(va, vb);
+    double bd = vec3_dot(da, db), d1 = vec3_dot(da, w), e1 = vec3_dot(db, w);
+    double denom = 1.0 - bd * bd;
+    denom = denom > 1e-12 ? denom : 1e-12;
+    double sa = clamp((bd * e1 - d1) / denom, -hda, hda);
+    double sb = clamp((e1 - bd * d1) / denom, -hdb, hdb);
+    Vector pe = vec3_scale(vec3_add(vec3_madd(va, sa, da), vec3_madd(vb, sb, db)), 0.5);
+
+    Vector p = vec3_scale(vec3_madd(vb, 0.5 * best.overlap, n), face_a);
+    p = vec3_add(p, vec3_scale(vec3_madd(va, -0.5 * best.overlap, n), face_b));
+    p = vec3_add(p, vec3_scale(pe, edge));
+
+    Contact c = {p, n, best.overlap};
+    return c;
+}
+
+static void box_box_kernel(ContactBatch* batch) {
+    const size_t n = batch->count;
+    const size_t stride = batch->capacity;
+    const double* restrict a = batch->columns;
+    const double* restrict b = COLUMN(batch, BOX_FIELDS);
+    const size_t out = 2 * BOX_FIELDS;
+    double* restrict px = COLUMN(batch, out + OUT_PX);
+    double* restrict py = COLUMN(batch, out + OUT_PY);
+    double* restrict pz = COLUMN(batch, out + OUT_PZ);
+    double* restrict nx = COLUMN(batch, out + OUT_NX);
+    double* restrict ny = COLUMN(batch, out + OUT_NY);
+    double* restrict nz = COLUMN(batch, out + OUT_NZ);
+    double* restrict depth = COLUMN(batch, out + OUT_DEPTH);
+
+#define BOX_FIELD(body, f) (body)[(size_t)(f) * stride + i]
+#define BOX_VECTOR(body, f) vec3(BOX_FIELD(body, f), BOX_FIELD(body, (f) + 1), BOX_FIELD(body, (f) + 2))
+    #pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+        Contact c = box_box_contact(BOX_VECTOR(a, BOX_X), BOX_VECTOR(a, BOX_U0X), BOX_VECTOR(a, BOX_U1X), BOX_VECTOR(a, BOX_U2X),
+                                    BOX_FIELD(a, BOX_H0), BOX_FIELD(a, BOX_H1), BOX_FIELD(a, BOX_H2),
+                                    BOX_VECTOR(b, BOX_X), BOX_VECTOR(b, BOX_U0X), BOX_VECTOR(b, BOX_U1X), BOX_VECTOR(b, BOX_U2X),
+                                    BOX_FIELD(b, BOX_H0), BOX_FIELD(b, BOX_H1), BOX_FIELD(b, BOX_H2));
+        px[i] = c.point.x; py[i] = c.point.y; pz[i] = c.point.z;
+        nx[i] = c.normal.x; ny[i] = c.normal.y; nz[i] = c.normal.z;
+        depth[i] = c.depth;
+    }
+#undef BOX_VECTOR
+#undef BOX_FIELD
+}
+
+typedef void (*ContactKernel)(ContactBatch* batch);
+
+static const ContactKernel kernels[CONTACT_PAIR_COUNT] = {
+    sphere_sphere_kernel,
+    sphere_box_kernel,
+    sphere_cylinder_kernel,
+    box_box_kernel
+};
+
+size_t narrowphase_run(NarrowPhase* np) {
+    if (!np) return 0;
+    size_t touching = 0;
+
+    for (int t = 0; t < CONTACT_PAIR_COUNT; t++) {
+        ContactBatch* batch = &np->batches[t];
+        if (batch->count == 0) continue;
+        kernels[t](batch);
+
+        size_t out = PAIR_FIELDS(t);
+        const double* px = COLUMN(batch, out + OUT_PX);
+        const double* py = COLUMN(batch, out + OUT_PY);
+        const double* pz = COLUMN(batch, out + OUT_PZ);
+        const double* nx = COLUMN(batch, out + OUT_NX);
+        const double* ny = COLUMN(batch, out + OUT_NY);
+        const double* nz = COLUMN(batch, out + OUT_NZ);
+        const double* depth = COLUMN(batch, out + OUT_DEPTH);
+
+        for (size_t i = 0; i < batch->count; i++) {
+            double flip = batch->swapped[i] ? -1.0 : 1.0;
+            Contact* c = &np->contacts[batch->pair[i]];
+            c->point = vec3(px[i], py[i], pz[i]);
+            c->normal = vec3(flip * nx[i], flip * ny[i], flip * nz[i]);
+            c->depth = depth[i];
+            touching += depth[i] > 0.0;
+        }
+    }
+    return touching;
+}
+
+NarrowPhaseErrorCode narrowphase_collide(const Entity* a, const SceneShape* shape_a,
+                                         const Entity* b, const SceneShape* shape_b, Contact* out) {
+    if (!a || !b || !shape_a || !shape_b || !out) return NARROWPHASE_ERROR_NULL_POINTER;
+
+    bool swapped;
+    int type = classify_pair(shape_a, shape_b, &swapped);
+    if (type < 0) return NARROWPHASE_ERROR_UNSUPPORTED_PAIR;
+
+    // a batch of one on the stack
+    double columns[2 * BOX_FIELDS + OUT_FIELDS];
+    size_t pair = 0;
+    unsigned char flag = swapped;
+    ContactBatch batch = {1, 1, columns, &pair, &flag};
+    if (swapped) {
+        gather_pair(&batch, (ContactPairType)type, 0, b, shape_b, a, shape_a);
+    } else {
+        gather_pair(&batch, (ContactPairType)type, 0, a, shape_a, b, shape_b);
+    }
+    kernels[type](&batch);
+
+    size_t base = PAIR_FIELDS(type);
+    double flip = swapped ? -1.0 : 1.0;
+    out->point = vec3(columns[base + OUT_PX], columns[base + OUT_PY], columns[base + OUT_PZ]);
+    out->normal = vec3(flip * columns[base + OUT_NX], flip * columns[base + OUT_NY], flip * columns[base + OUT_NZ]);
+    out->depth = columns[base + OUT_DEPTH];
+    return NARROWPHASE_SUCCESS;
+}
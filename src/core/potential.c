@@ -0,0 +1,378 @@
+#include "../../include/core/potential.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CPHYSICS_POTENTIAL_KERNELS(name, NAME) CPHYSICS_PAIR_KERNELS(potential_##name)
+CPHYSICS_POTENTIALS(CPHYSICS_POTENTIAL_KERNELS)
+#undef CPHYSICS_POTENTIAL_KERNELS
+
+typedef struct PairKernels {
+    void (*direct_sum)(PairSystem* s, const PotentialParams* p);
+    void (*neighbor_list)(PairSystem* s, const NeighborList* nl, const PotentialParams* p);
+} PairKernels;
+
+// selected once per evaluation, the pair loops themselves are specialised per potential
+static const PairKernels kernels[POTENTIAL_COUNT] = {
+#define CPHYSICS_POTENTIAL_TABLE(name, NAME) [POTENTIAL_##NAME] = {potential_##name##_direct_sum, potential_##name##_neighbor_list},
+    CPHYSICS_POTENTIALS(CPHYSICS_POTENTIAL_TABLE)
+#undef CPHYSICS_POTENTIAL_TABLE
+};
+
+PotentialErrorCode pair_system_load(PairSystem* s, const Entity* entities, size_t count, const double* radii) {
+    if (!s || (count > 0 && !entities)) return POTENTIAL_ERROR_NULL_POINTER;
+
+    if (count > s->capacity) {
+        size_t capacity = s->capacity ? s->capacity : 64;
+        while (capacity < count) capacity *= 2;
+        // one block, nine columns
+        double* block = malloc(9 * capacity * sizeof(double));
+        if (!block) return POTENTIAL_ERROR_OUT_OF_MEMORY;
+        free(s->x);
+        s->x = block;
+        s->y = block + capacity;
+        s->z = block + 2 * capacity;
+        s->charge = block + 3 * capacity;
+        s->radius = block + 4 * capacity;
+        s->inv_mass = block + 5 * capacity;
+        s->ax = block + 6 * capacity;
+        s->ay = block + 7 * capacity;
+        s->az = block + 8 * capacity;
+        s->capacity = capacity;
+    }
+    s->count = count;
+    s->energy = 0.0;
+
+    long n = (long)count;
+    #pragma omp parallel for schedule(static) if(n > POTENTIAL_PARALLEL_THRESHOLD * 64)
+    for (long i = 0; i < n; i++) {
+        const Entity* e = &entities[i];
+        s->x[i] = e->position.x;
+        s->y[i] = e->position.y;
+        s->z[i] = e->position.z;
+        s->charge[i] = e->charge;
+        s->radius[i] = radii ? radii[i] : 0.0;
+        s->inv_mass[i] = e->is_static || e->mass <= 0.0 ? 0.0 : 1.0 / e->mass;
+    }
+    return POTENTIAL_SUCCESS;
+}
+
+void pair_system_store(const PairSystem* s, Entity* entities) {
+    if (!s || !entities) return;
+    long n = (long)s->count;
+    #pragma omp parallel for schedule(static) if(n > POTENTIAL_PARALLEL_THRESHOLD * 64)
+    for (long i = 0; i < n; i++) {
+        if (entities[i].is_static) continue;
+        entities[i].acceleration.x += s->ax[i];
+        entities[i].acceleration.y += s->ay[i];
+        entities[i].acceleration.z += s->az[i];
+    }
+}
+
+void pair_system_free(PairSystem* s) {
+    if (!s) return;
+    free(s->x);
+    memset(s, 0, sizeof(*s));
+}
+
+PotentialErrorCode neighbor_list_init(NeighborList* nl, double cutoff, double skin) {
+    if (!nl) return POTENTIAL_ERROR_NULL_POINTER;
+    memset(nl, 0, sizeof(*nl));
+    if (!(cutoff > 0.0) || !(skin >= 0.0) || !isfinite(cutoff + skin)) return POTENTIAL_ERROR_INVALID_PARAMS;
+    nl->cutoff = cutoff;
+    nl->skin = skin;
+    return POTENTIAL_SUCCESS;
+}
+
+void neighbor_list_free(NeighborList* nl) {
+    if (!nl) return;
+    free(nl->offsets);
+    free(nl->neighbors);
+    free(nl->reference);
+    free(nl->cell_of);
+    free(nl->cell_start);
+    free(nl->cell_items);
+    memset(nl, 0, sizeof(*nl));
+}
+
+static bool needs_rebuild(const NeighborList* nl, const PairSystem* s) {
+    if (nl->builds == 0 || nl->count != s->count) return true;
+
+    double limit = 0.25 * nl->skin * nl->skin;
+    const double* ref = nl->reference;
+    long n = (long)s->count;
+    int moved = 0;
+    #pragma omp parallel for schedule(static) reduction(|:moved) if(n > POTENTIAL_PARALLEL_THRESHOLD * 64)
+    for (long i = 0; i < n; i++) {
+        double dx = s->x[i] - ref[3 * i], dy = s->y[i] - ref[3 * i + 1], dz = s->z[i] - ref[3 * i + 2];
+        moved |= dx * dx + dy * dy + dz * dz > limit;
+    }
+    return moved != 0;
+}
+
+static bool grow_list(NeighborList* nl, size_t count, size_t cells) {
+    if (count > nl->capacity) {
+        size_t* offsets = realloc(nl->offsets, (count + 1) * sizeof(size_t));
+        if (!offsets) return false;
+        nl->offsets = offsets;
+        double* reference = realloc(nl->reference, 3 * count * sizeof(double));
+        if (!reference) return false;
+        nl->reference = reference;
+        uint32_t* cell_of = realloc(nl->cell_of, count * sizeof(uint32_t));
+        if (!cell_of) return false;
+        nl->cell_of = cell_of;
+        uint32_t* items = realloc(nl->cell_items, count * sizeof(uint32_t));
+        if (!items) return false;
+        nl->cell_items = items;
+        nl->capacity = count;
+    }
+    if (cells + 1 > nl->cell_capacity) {
+        uint32_t* start = realloc(nl->cell_start, (cells + 1) * sizeof(uint32_t));
+        if (!start) return false;
+        nl->cell_start = start;
+        nl->cell_capacity = cells + 1;
+    }
+    return true;
+}
+
+/**
+ * Visit the bodies of the 27 cells around the cell of i, count or store those within range.
+ */
+static size_t gather_neighbors(const NeighborList* nl, const PairSystem* s, const size_t cells[3], size_t i,
+                               double range2, uint32_t* out) {
+    uint32_t cell = nl->cell_of[i];
+    size_t c[3] = {cell % cells[0], cell / cells[0] % cells[1], cell / cells[0] / cells[1]};
+    size_t lo[3], hi[3];
+    for (int a = 0; a < 3; a++) {
+        lo[a] = c[a] > 0 ? c[a] - 1 : 0;
+        hi[a] = c[a] + 1 < cells[a] ? c[a] + 1 : c[a];
+    }
+
+    double xi = s->x[i], yi = s->y[i], zi = s->z[i];
+    size_t found = 0;
+    for (size_t cz = lo[2]; cz <= hi[2]; cz++) {
+        for (size_t cy = lo[1]; cy <= hi[1]; cy++) {
+            // cells adjacent along x are contiguous in cell_items
+            size_t row = (cz * cells[1] + cy) * cells[0];
+            uint32_t begin = nl->cell_start[row + lo[0]], end = nl->cell_start[row + hi[0] + 1];
+            for (uint32_t k = begin; k < end; k++) {
+                uint32_t j = nl->cell_items[k];
+                double dx = xi - s->x[j], dy = yi - s->y[j], dz = zi - s->z[j];
+                if (j != i && dx * dx + dy * dy + dz * dz < range2) {
+                    if (out) out[found] = j;
+                    found++;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+static PotentialErrorCode build(NeighborList* nl, const PairSystem* s) {
+    size_t n = s->count;
+    double range = nl->cutoff + nl->skin;
+
+    double lo[3] = {INFINITY, INFINITY, INFINITY}, hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (size_t i = 0; i < n; i++) {
+        double p[3] = {s->x[i], s->y[i], s->z[i]};
+        for (int a = 0; a < 3; a++) {
+            lo[a] = p[a] < lo[a] ? p[a] : lo[a];
+            hi[a] = p[a] > hi[a] ? p[a] : hi[a];
+        }
+    }
+
+    // cells at least one range wide, about one per body at most
+    size_t cells[3], total = 1;
+    double inv_size[3];
+    for (int a = 0; a < 3; a++) {
+        double extent = n ? hi[a] - lo[a] : 0.0;
+        double k = floor(extent / range);
+        double limit = cbrt((double)(n ? n : 1)) + 1.0;
+        k = k < 1.0 ? 1.0 : k > limit ? limit : k;
+        cells[a] = (size_t)k;
+        inv_size[a] = extent > 0.0 ? k / extent : 0.0;
+        total *= cells[a];
+    }
+    if (!grow_list(nl, n ? n : 1, total)) return POTENTIAL_ERROR_OUT_OF_MEMORY;
+
+    // counting sort of bodies by cell
+    memset(nl->cell_start, 0, (total + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++) {
+        double p[3] = {s->x[i], s->y[i], s->z[i]};
+        size_t c[3];
+        for (int a = 0; a < 3; a++) {
+            double g = (p[a] - lo[a]) * inv_size[a];
+            c[a] = g > 0.0 ? (size_t)g : 0;
+            if (c[a] >= cells[a]) c[a] = cells[a] - 1;
+        }
+        uint32_t cell = (uint32_t)((c[2] * cells[1] + c[1]) * cells[0] + c[0]);
+        nl->cell_of[i] = cell;
+        nl->cell_start[cell + 1]++;
+    }
+    for (size_t c = 0; c < total; c++) nl->cell_start[c + 1] += nl->cell_start[c];
+    for (size_t i = 0; i < n; i++) {
+        // cell_start[cell] is used as the fill cursor and restored below
+        nl->cell_items[nl->cell_start[nl->cell_of[i]]++] = (uint32_t)i;
+    }
+    for (size_t c = total; c > 0; c--) nl->cell_start[c] = nl->cell_start[c - 1];
+    nl->cell_start[0] = 0;
+
+    // two passes, count then fill, so rows can be written in parallel
+    double range2 = range * range;
+    long ln = (long)n;
+    nl->offsets[0] = 0;
+    #pragma omp parallel for schedule(dynamic, 256) if(ln > POTENTIAL_PARALLEL_THRESHOLD)
+    for (long i = 0; i < ln; i++) {
+        nl->offsets[i + 1] = gather_neighbors(nl, s, cells, (size_t)i, range2, NULL);
+    }
+    for (size_t i = 0; i < n; i++) nl->offsets[i + 1] += nl->offsets[i];
+
+    size_t pairs = nl->offsets[n];
+    if (pairs > nl->neighbor_capacity) {
+        size_t capacity = pairs + pairs / 4;
+        uint32_t* neighbors = realloc(nl->neighbors, (capacity ? capacity : 1) * sizeof(uint32_t));
+        if (!neighbors) return POTENTIAL_ERROR_OUT_OF_MEMORY;
+        nl->neighbors = neighbors;
+        nl->neighbor_capacity = capacity;
+    }
+    #pragma omp parallel for schedule(dynamic, 256) if(ln > POTENTIAL_PARALLEL_THRESHOLD)
+    for (long i = 0; i < ln; i++) {
+        gather_neighbors(nl, s, cells, (size_t)i, range2, nl->neighbors + nl->offsets[i]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        nl->reference[3 * i] = s->x[i];
+        nl->reference[3 * i + 1] = s->y[i];
+        nl->reference[3 * i + 2] = s->z[i];
+    }
+    nl->count = n;
+    nl->builds++;
+    return POTENTIAL_SUCCESS;
+}
+
+PotentialErrorCode neighbor_list_update(NeighborList* nl, const PairSystem* s, bool* rebuilt) {
+    if (rebuilt) *rebuilt = false;
+    if (!nl || !s) return POTENTIAL_ERROR_NULL_POINTER;
+    if (s->count >= UINT32_MAX) return POTENTIAL_ERROR_INVALID_PARAMS;
+    if (!needs_rebuild(nl, s)) return POTENTIAL_SUCCESS;
+
+    PotentialErrorCode rc = build(nl, s);
+    if (rc == POTENTIAL_SUCCESS && rebuilt) *rebuilt = true;
+    return rc;
+}
+
+void potential_default_params(PotentialType type, PotentialParams* params) {
+    if (!params) return;
+    memset(params, 0, sizeof(*params));
+    switch (type) {
+        case POTENTIAL_LENNARD_JONES:
+            // argon
+            params->epsilon = 1.654e-21;
+            params->sigma = 3.405e-10;
+            params->cutoff = 2.5 * params->sigma;
+            break;
+        case POTENTIAL_YUKAWA:
+            params->strength = 8.987551787e9;
+            params->kappa = 1e9;
+            params->cutoff = 5.0 / params->kappa;
+            break;
+        case POTENTIAL_HERTZ:
+            // glass beads, cutoff must cover the largest sum of two radii
+            params->modulus = 3.5e10;
+            params->cutoff = 1e-2;
+            break;
+        default:
+            break;
+    }
+}
+
+static bool valid_params(PotentialType type, const PotentialParams* p) {
+    if (!(p->cutoff > 0.0) || !isfinite(p->cutoff)) return false;
+    switch (type) {
+        case POTENTIAL_LENNARD_JONES: return p->sigma > 0.0 && p->epsilon >= 0.0;
+        case POTENTIAL_YUKAWA: return p->kappa >= 0.0;
+        case POTENTIAL_HERTZ: return p->modulus >= 0.0;
+        default: return false;
+    }
+}
+
+PotentialErrorCode potential_force_init(PotentialForce* force, PotentialType type, const PotentialParams* params,
+                                        const double* radii, bool use_neighbor_list, double skin) {
+    if (!force) return POTENTIAL_ERROR_NULL_POINTER;
+    memset(force, 0, sizeof(*force));
+    if ((unsigned)type >= POTENTIAL_COUNT) return POTENTIAL_ERROR_UNKNOWN_TYPE;
+
+    force->type = type;
+    if (params) force->params = *params;
+    else potential_default_params(type, &force->params);
+    if (!valid_params(type, &force->params)) return POTENTIAL_ERROR_INVALID_PARAMS;
+    if (type == POTENTIAL_HERTZ && !radii) return POTENTIAL_ERROR_NULL_POINTER;
+
+    force->radii = radii;
+    force->use_neighbor_list = use_neighbor_list;
+    if (use_neighbor_list) {
+        return neighbor_list_init(&force->neighbors, force->params.cutoff, skin);
+    }
+    return POTENTIAL_SUCCESS;
+}
+
+void potential_force_free(PotentialForce* force) {
+    if (!force) return;
+    neighbor_list_free(&force->neighbors);
+    pair_system_free(&force->system);
+}
+
+/**
+ * Radii must be positive and finite, and the cutoff has to cover the largest contact distance 2 max(radius).
+ * A smaller cutoff would skip touching pairs and switch their force off while they still overlap.
+ */
+static bool valid_radii(const double* radii, size_t count, double cutoff) {
+    long n = (long)count;
+    int bad = 0;
+    double largest = 0.0;
+    #pragma omp parallel for schedule(static) reduction(|:bad) reduction(max:largest) \
+        if(n > POTENTIAL_PARALLEL_THRESHOLD * 64)
+    for (long i = 0; i < n; i++) {
+        bad |= !(radii[i] > 0.0 && radii[i] < INFINITY);
+        largest = radii[i] > largest ? radii[i] : largest;
+    }
+    return bad == 0 && 2.0 * largest <= cutoff;
+}
+
+static PotentialErrorCode apply(PotentialForce* force, Entity* entities, size_t count) {
+    if (count > 0 && !entities) return POTENTIAL_ERROR_NULL_POINTER;
+    if ((unsigned)force->type >= POTENTIAL_COUNT) return POTENTIAL_ERROR_UNKNOWN_TYPE;
+    // the radii array only gets its length here, contact with a zero sized body has no defined stiffness
+    if (force->type == POTENTIAL_HERTZ &&
+        (!force->radii || !valid_radii(force->radii, count, force->params.cutoff))) {
+        return POTENTIAL_ERROR_INVALID_PARAMS;
+    }
+
+    PotentialErrorCode rc = pair_system_load(&force->system, entities, count, force->radii);
+    if (rc != POTENTIAL_SUCCESS) return rc;
+
+    const PairKernels* k = &kernels[force->type];
+    if (force->use_neighbor_list) {
+        rc = neighbor_list_update(&force->neighbors, &force->system, NULL);
+        if (rc != POTENTIAL_SUCCESS) return rc;
+        k->neighbor_list(&force->system, &force->neighbors, &force->params);
+    } else {
+        k->direct_sum(&force->system, &force->params);
+    }
+
+    pair_system_store(&force->system, entities);
+    force->energy = force->system.energy;
+    return POTENTIAL_SUCCESS;
+}
+
+PotentialErrorCode potential_apply(PotentialForce* force, Entity* entities, size_t count) {
+    if (!force) return POTENTIAL_ERROR_NULL_POINTER;
+    // nothing is added to the entities before the last check passed
+    PotentialErrorCode rc = apply(force, entities, count);
+    if (rc != POTENTIAL_SUCCESS) force->energy = 0.0;
+    force->error = rc;
+    return rc;
+}
+
+void potential_accelerations(Entity* entities, size_t count, void* user) {
+    potential_apply((PotentialForce*)user, entities, count);
+}
@@ -0,0 +1,376 @@
+#include "../../include/core/reorder.h"
+#include "../../include/core/time_flow.h"
+#include "../../include/mathlib/vec_math.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// below this the sort and the copies run on one thread
+#define REORDER_PARALLEL_THRESHOLD 32768
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+void reorder_default_config(ReorderConfig* config) {
+    if (!config) return;
+    config->locality_threshold = 2.0;
+    config->min_count = 1024;
+}
+
+ReorderErrorCode reorder_init(EntityReorder* r, const ReorderConfig* config, size_t count) {
+    if (!r) return REORDER_ERROR_NULL_POINTER;
+    memset(r, 0, sizeof(*r));
+    if (config) r->config = *config;
+    else reorder_default_config(&r->config);
+    if (!(r->config.locality_threshold >= 1.0) || count > UINT32_MAX) return REORDER_ERROR_INVALID_CONFIG;
+
+    size_t n = count ? count : 1;
+    r->count = count;
+    r->handle_to_index = malloc(n * sizeof(uint32_t));
+    r->index_to_handle = malloc(n * sizeof(uint32_t));
+    r->keys = malloc(n * sizeof(uint64_t));
+    r->keys_swap = malloc(n * sizeof(uint64_t));
+    r->order = malloc(n * sizeof(uint32_t));
+    r->order_swap = malloc(n * sizeof(uint32_t));
+    if (!r->handle_to_index || !r->index_to_handle || !r->keys || !r->keys_swap || !r->order || !r->order_swap) {
+        reorder_free(r);
+        return REORDER_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        r->handle_to_index[i] = (uint32_t)i;
+        r->index_to_handle[i] = (uint32_t)i;
+        r->order[i] = (uint32_t)i;
+    }
+    return REORDER_SUCCESS;
+}
+
+void reorder_free(EntityReorder* r) {
+    if (!r) return;
+    free(r->handle_to_index);
+    free(r->index_to_handle);
+    free(r->keys);
+    free(r->keys_swap);
+    free(r->order);
+    free(r->order_swap);
+    free(r->scratch);
+    memset(r, 0, sizeof(*r));
+}
+
+static void bounds(const Entity* entities, size_t count, Vector* lo, Vector* hi) {
+    double min_x = INFINITY, min_y = INFINITY, min_z = INFINITY;
+    double max_x = -INFINITY, max_y = -INFINITY, max_z = -INFINITY;
+    long n = (long)count;
+
+    #pragma omp parallel for schedule(static) if(n > REORDER_PARALLEL_THRESHOLD) \
+        reduction(min:min_x, min_y, min_z) reduction(max:max_x, max_y, max_z)
+    for (long i = 0; i < n; i++) {
+        Vector p = entities[i].position;
+        min_x = p.x < min_x ? p.x : min_x;
+        min_y = p.y < min_y ? p.y : min_y;
+        min_z = p.z < min_z ? p.z : min_z;
+        max_x = p.x > max_x ? p.x : max_x;
+        max_y = p.y > max_y ? p.y : max_y;
+        max_z = p.z > max_z ? p.z : max_z;
+    }
+
+    *lo = vec3(min_x, min_y, min_z);
+    *hi = vec3(max_x, max_y, max_z);
+}
+
+static double locality(const Entity* entities, size_t count, Vector lo, Vector hi) {
+    if (count < 2) return 0.0;
+    Vector extent = vec3_sub(hi, lo);
+    double largest = extent.x > extent.y ? extent.x : extent.y;
+    largest = extent.z > largest ? extent.z : largest;
+    // spacing of count points spread over the largest extent, also meaningful for flat or linear sets
+    double spacing = largest / cbrt((double)count);
+    if (!(spacing > 0.0)) return 0.0;
+
+    double sum = 0.0;
+    long n = (long)count - 1;
+    #pragma omp parallel for schedule(static) if(n > REORDER_PARALLEL_THRESHOLD) reduction(+:sum)
+    for (long i = 0; i < n; i++) {
+        sum += vec3_distance(entities[i].position, entities[i + 1].position);
+    }
+    return sum / (double)n / spacing;
+}
+
+double reorder_locality(const Entity* entities, size_t count) {
+    if (!entities || count < 2) return 0.0;
+    Vector lo, hi;
+    bounds(entities, count, &lo, &hi);
+    return locality(entities, count, lo, hi);
+}
+
+/**
+ * Spread the low 21 bits of v so that two zero bits follow each of them.
+ */
+static inline uint64_t spread_bits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x001f00000000ffffull;
+    v = (v | v << 16) & 0x001f0000ff0000ffull;
+    v = (v | v << 8) & 0x100f00f00f00f00full;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+}
+
+static inline uint64_t quantize(double x, double lo, double scale, uint64_t max) {
+    double q = (x - lo) * scale;
+    if (!(q > 0.0)) return 0;
+    return q >= (double)max ? max : (uint64_t)q;
+}
+
+/**
+ * Bits per axis: about 8 cells per entity along each axis, finer grids only add radix passes.
+ */
+static int key_bits(size_t count) {
+    int bits = (int)ceil(log2(cbrt((double)count))) + 3;
+    return bits < 1 ? 1 : bits > 21 ? 21 : bits;
+}
+
+static void morton_keys(EntityReorder* r, const Entity* entities, Vector lo, Vector hi, int bits) {
+    uint64_t max = ((uint64_t)1 << bits) - 1;
+    Vector extent = vec3_sub(hi, lo);
+    double sx = extent.x > 0.0 ? (double)max / extent.x : 0.0;
+    double sy = extent.y > 0.0 ? (double)max / extent.y : 0.0;
+    double sz = extent.z > 0.0 ? (double)max / extent.z : 0.0;
+    uint64_t* keys = r->keys;
+    uint32_t* order = r->order;
+    long n = (long)r->count;
+
+    #pragma omp parallel for schedule(static) if(n > REORDER_PARALLEL_THRESHOLD)
+    for (long i = 0; i < n; i++) {
+        Vector p = entities[i].position;
+        keys[i] = spread_bits(quantize(p.x, lo.x, sx, max)) |
+                  spread_bits(quantize(p.y, lo.y, sy, max)) << 1 |
+                  spread_bits(quantize(p.z, lo.z, sz, max)) << 2;
+        order[i] = (uint32_t)i;
+    }
+}
+
+/**
+ * Stable LSD radix sort of keys carrying order along, 8 bits per pass.
+ *
+ * Every thread histograms its own contiguous block, a prefix sum over (bucket, thread) gives each thread its
+ * output offsets so the scatter needs no atomics. Digits on which all keys agree are skipped.
+ */
+static ReorderErrorCode radix_sort(EntityReorder* r, int key_bits_total) {
+    size_t n = r->count;
+    uint64_t first = r->keys[0], diff = 0;
+    const uint64_t* all = r->keys;
+    long ln = (long)n;
+    #pragma omp parallel for schedule(static) if(ln > REORDER_PARALLEL_THRESHOLD) reduction(|:diff)
+    for (long i = 0; i < ln; i++) {
+        diff |= all[i] ^ first;
+    }
+
+    int max_threads = 1;
+#ifdef _OPENMP
+    if (n > REORDER_PARALLEL_THRESHOLD) max_threads = omp_get_max_threads();
+#endif
+    size_t* hist = malloc((size_t)max_threads * RADIX_BUCKETS * sizeof(size_t));
+    if (!hist) return REORDER_ERROR_OUT_OF_MEMORY;
+
+    int passes = 0;
+    for (int shift = 0; shift < key_bits_total; shift += RADIX_BITS) {
+        if (((diff >> shift) & (RADIX_BUCKETS - 1)) == 0) continue;
+
+        const uint64_t* keys = r->keys;
+        const uint32_t* order = r->order;
+        uint64_t* keys_out = r->keys_swap;
+        uint32_t* order_out = r->order_swap;
+
+        #pragma omp parallel num_threads(max_threads)
+        {
+            int t = 0, threads = 1;
+#ifdef _OPENMP
+            t = omp_get_thread_num();
+            threads = omp_get_num_threads();
+#endif
+            size_t begin = n * (size_t)t / (size_t)threads;
+            size_t end = n * (size_t)(t + 1) / (size_t)threads;
+            size_t* h = hist + (size_t)t * RADIX_BUCKETS;
+
+            memset(h, 0, RADIX_BUCKETS * sizeof(size_t));
+            for (size_t i = begin; i < end; i++) {
+                h[(keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+            }
+
+            #pragma omp barrier
+            #pragma omp single
+            {
+                size_t offset = 0;
+                for (int b = 0; b < RADIX_BUCKETS; b++) {
+                    for (int k = 0; k < threads; k++) {
+                        size_t c = hist[(size_t)k * RADIX_BUCKETS + b];
+                        hist[(size_t)k * RADIX_BUCKETS + b] = offset;
+                        offset += c;
+                    }
+                }
+            }
+
+            for (size_t i = begin; i < end; i++) {
+                size_t dst = h[(keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+                keys_out[dst] = keys[i];
+                order_out[dst] = order[i];
+            }
+        }
+
+        uint64_t* tk = r->keys; r->keys = r->keys_swap; r->keys_swap = tk;
+        uint32_t* to = r->order; r->order = r->order_swap; r->order_swap = to;
+        passes++;
+    }
+
+    free(hist);
+    r->stats.sort_passes = passes;
+    return REORDER_SUCCESS;
+}
+
+static bool grow_scratch(EntityReorder* r, size_t bytes) {
+    if (r->scratch_size >= bytes) return true;
+    void* p = realloc(r->scratch, bytes);
+    if (!p) return false;
+    r->scratch = p;
+    r->scratch_size = bytes;
+    return true;
+}
+
+/**
+ * Gather array into the order of the last sort. Entity arrays from run() are copied as structs, companion
+ * arrays of reorder_apply byte-wise since their element type is unknown.
+ */
+static void permute(EntityReorder* r, void* array, size_t element_size, bool entities) {
+    const uint32_t* order = r->order;
+    char* dst = r->scratch;
+    const char* src = array;
+    long n = (long)r->count;
+
+    if (entities) {
+        Entity* d = r->scratch;
+        const Entity* s = array;
+        #pragma omp parallel for schedule(static) if(n > REORDER_PARALLEL_THRESHOLD)
+        for (long i = 0; i < n; i++) {
+            d[i] = s[order[i]];
+        }
+    } else {
+        #pragma omp parallel for schedule(static) if(n > REORDER_PARALLEL_THRESHOLD)
+        for (long i = 0; i < n; i++) {
+            memcpy(dst + (size_t)i * element_size, src + (size_t)order[i] * element_size, element_size);
+        }
+    }
+
+    size_t bytes = r->count * element_size;
+    size_t chunk = bytes / 64 + 1;
+    long chunks = (long)((bytes + chunk - 1) / chunk);
+    #pragma omp parallel for schedule(static) if(n > REORDER_PARALLEL_THRESHOLD)
+    for (long c = 0; c < chunks; c++) {
+        size_t begin = (size_t)c * chunk;
+        size_t len = begin + chunk < bytes ? chunk : bytes - begin;
+        memcpy((char*)array + begin, dst + begin, len);
+    }
+}
+
+static ReorderErrorCode run(EntityReorder* r, Entity* entities, double before, Vector lo, Vector hi,
+                            double start, double bounds_ms) {
+    ReorderStats* st = &r->stats;
+    st->locality_before = before;
+    st->last_bounds_ms = bounds_ms;
+
+    double t = wall_clock_ms();
+    int bits = key_bits(r->count);
+    morton_keys(r, entities, lo, hi, bits);
+    st->key_bits = bits;
+    st->last_key_ms = wall_clock_ms() - t;
+
+    t = wall_clock_ms();
+    ReorderErrorCode rc = radix_sort(r, 3 * bits);
+    if (rc != REORDER_SUCCESS) return rc;
+    st->last_sort_ms = wall_clock_ms() - t;
+
+    t = wall_clock_ms();
+    if (!grow_scratch(r, r->count * sizeof(Entity))) return REORDER_ERROR_OUT_OF_MEMORY;
+    permute(r, entities, sizeof(Entity), true);
+
+    // handles follow their entities, order_swap is free after the sort
+    uint32_t* handles = r->order_swap;
+    const uint32_t* order = r->order;
+    long n = (long)r->count;
+    #pragma omp parallel for schedule(static) if(n > REORDER_PARALLEL_THRESHOLD)
+    for (long i = 0; i < n; i++) {
+        handles[i] = r->index_to_handle[order[i]];
+    }
+    r->order_swap = r->index_to_handle;
+    r->index_to_handle = handles;
+    #pragma omp parallel for schedule(static) if(n > REORDER_PARALLEL_THRESHOLD)
+    for (long i = 0; i < n; i++) {
+        r->handle_to_index[handles[i]] = (uint32_t)i;
+    }
+    st->last_permute_ms = wall_clock_ms() - t;
+
+    st->locality_after = locality(entities, r->count, lo, hi);
+    r->baseline = st->locality_after;
+    st->reorders++;
+    st->last_total_ms = wall_clock_ms() - start;
+    return REORDER_SUCCESS;
+}
+
+ReorderErrorCode reorder_run(EntityReorder* r, Entity* entities, size_t count) {
+    if (!r || !entities) return REORDER_ERROR_NULL_POINTER;
+    if (count != r->count) return REORDER_ERROR_COUNT_MISMATCH;
+    if (count < 2) return REORDER_SUCCESS;
+
+    double start = wall_clock_ms();
+    Vector lo, hi;
+    bounds(entities, count, &lo, &hi);
+    double bounds_ms = wall_clock_ms() - start;
+    return run(r, entities, locality(entities, count, lo, hi), lo, hi, start, bounds_ms);
+}
+
+ReorderErrorCode reorder_maybe(EntityReorder* r, Entity* entities, size_t count, bool* reordered) {
+    if (reordered) *reordered = false;
+    if (!r || !entities) return REORDER_ERROR_NULL_POINTER;
+    if (count != r->count) return REORDER_ERROR_COUNT_MISMATCH;
+    r->stats.checks++;
+    if (count < 2 || count < r->config.min_count) return REORDER_SUCCESS;
+
+    double start = wall_clock_ms();
+    Vector lo, hi;
+    bounds(entities, count, &lo, &hi);
+    double bounds_ms = wall_clock_ms() - start;
+    double metric = locality(entities, count, lo, hi);
+    if (r->baseline > 0.0 && metric <= r->config.locality_threshold * r->baseline) {
+        return REORDER_SUCCESS;
+    }
+
+    ReorderErrorCode rc = run(r, entities, metric, lo, hi, start, bounds_ms);
+    if (rc == REORDER_SUCCESS && reordered) *reordered = true;
+    return rc;
+}
+
+ReorderErrorCode reorder_apply(EntityReorder* r, void* array, size_t element_size) {
+    if (!r || !array) return REORDER_ERROR_NULL_POINTER;
+    if (element_size == 0) return REORDER_ERROR_INVALID_CONFIG;
+    if (r->count < 2) return REORDER_SUCCESS;
+    if (!grow_scratch(r, r->count * element_size)) return REORDER_ERROR_OUT_OF_MEMORY;
+    permute(r, array, element_size, false);
+    return REORDER_SUCCESS;
+}
+
+size_t reorder_index_of(const EntityReorder* r, size_t handle) {
+    if (!r || handle >= r->count) return SIZE_MAX;
+    return r->handle_to_index[handle];
+}
+
+size_t reorder_handle_of(const EntityReorder* r, size_t index) {
+    if (!r || index >= r->count) return SIZE_MAX;
+    return r->index_to_handle[index];
+}
+
+ReorderStats reorder_stats(const EntityReorder* r) {
+    ReorderStats empty = {0};
+    return r ? r->stats : empty;
+}
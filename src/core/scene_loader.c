@@ -0,0 +1,527 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     // strtod_l
+#endif
+#include "../../include/core/scene_loader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <locale.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define SCENE_FIELDS_MIN 16
+#define SCENE_FIELDS_MAX 19
+#define SCENE_MIN_CHUNK (64 * 1024)
+#define SCENE_NAME_MAX 255
+
+typedef struct SceneChunk {
+    const char* begin;
+    const char* end;
+    size_t records;
+    size_t lines;
+    size_t first_record;
+    size_t first_line;
+    SceneLoadError error;
+    bool failed;
+} SceneChunk;
+
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+#ifdef _WIN32
+static _locale_t c_locale;
+static INIT_ONCE c_locale_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK init_c_locale(PINIT_ONCE once, PVOID param, PVOID* context) {
+    (void)once; (void)param; (void)context;
+    c_locale = _create_locale(LC_NUMERIC, "C");
+    return TRUE;
+}
+
+// strtod in the C locale, so a decimal point is '.' whatever setlocale selected
+static double strtod_c(const char* s) {
+    InitOnceExecuteOnce(&c_locale_once, init_c_locale, NULL, NULL);
+    return c_locale ? _strtod_l(s, NULL, c_locale) : strtod(s, NULL);
+}
+#else
+static locale_t c_locale;
+static pthread_once_t c_locale_once = PTHREAD_ONCE_INIT;
+
+static void init_c_locale(void) {
+    c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+}
+
+// strtod in the C locale, so a decimal point is '.' whatever setlocale selected
+static double strtod_c(const char* s) {
+    pthread_once(&c_locale_once, init_c_locale);
+    return c_locale ? strtod_l(s, NULL, c_locale) : strtod(s, NULL);
+}
+#endif
+
+/**
+ * Decimal to double. Mantissas up to 2^53 with |exponent| <= 22 are exact in one multiplication or
+ * division; anything else falls back to strtod so results are always correctly rounded.
+ */
+static bool parse_double(const char* p, const char* end, double* out) {
+    const char* start = p;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+
+    while (p < end && *p >= '0' && *p <= '9') {
+        any = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            if (mantissa) digits++;
+        } else {
+            exponent++;
+        }
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            any = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                if (mantissa) digits++;
+                exponent--;
+            }
+            p++;
+        }
+    }
+    if (!any) return false;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool exp_negative = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            exp_negative = *p == '-';
+            p++;
+        }
+        if (p == end || *p < '0' || *p > '9') return false;
+        int e = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (e < 100000) e = e * 10 + (*p - '0');
+            p++;
+        }
+        exponent += exp_negative ? -e : e;
+    }
+    if (p != end) return false;
+
+    if (mantissa <= (UINT64_C(1) << 53) && exponent >= -22 && exponent <= 22) {
+        double v = (double)mantissa;
+        v = exponent < 0 ? v / exact_powers_of_ten[-exponent] : v * exact_powers_of_ten[exponent];
+        *out = negative ? -v : v;
+        return true;
+    }
+
+    char buf[128];
+    size_t len = (size_t)(end - start);
+    if (len >= sizeof(buf)) return false;
+    memcpy(buf, start, len);
+    buf[len] = '\0';
+    *out = strtod_c(buf);
+    return true;
+}
+
+static bool token_equals(const char* p, const char* end, const char* word) {
+    size_t len = strlen(word);
+    return (size_t)(end - p) == len && memcmp(p, word, len) == 0;
+}
+
+static bool parse_bool(const char* p, const char* end, bool* out) {
+    if (token_equals(p, end, "1") || token_equals(p, end, "true")) {
+        *out = true;
+        return true;
+    }
+    if (token_equals(p, end, "0") || token_equals(p, end, "false")) {
+        *out = false;
+        return true;
+    }
+    return false;
+}
+
+static bool parse_shape(const char* p, const char* end, ShapeType* out) {
+    if (token_equals(p, end, "point")) *out = SHAPE_POINT;
+    else if (token_equals(p, end, "sphere")) *out = SHAPE_SPHERE;
+    else if (token_equals(p, end, "cylinder")) *out = SHAPE_CYLINDER;
+    else if (token_equals(p, end, "cube")) *out = SHAPE_CUBE;
+    else return false;
+    return true;
+}
+
+static void set_error(SceneLoadError* err, size_t line, int column, const char* message) {
+    err->line = line;
+    err->column = column;
+    snprintf(err->message, sizeof(err->message), "%s", message);
+}
+
+/**
+ * Parse one record line into e / shape, returns false and fills err on failure.
+ */
+static bool parse_record(const char* p, const char* end, size_t line, Entity* e, SceneShape* shape,
+                         SceneLoadError* err) {
+    static const char* field_names[SCENE_FIELDS_MAX] = {
+        "shape", "name", "mass", "charge", "px", "py", "pz", "vx", "vy", "vz",
+        "ax", "ay", "az", "restitution", "rigid", "static", "radius", "height", "width"
+    };
+
+    const char* tok_begin[SCENE_FIELDS_MAX];
+    const char* tok_end[SCENE_FIELDS_MAX];
+    int n = 0;
+
+    for (;;) {
+        if (n == SCENE_FIELDS_MAX) {
+            set_error(err, line, 0, "too many fields");
+            return false;
+        }
+        while (p < end && is_blank(*p)) p++;
+        const char* b = p;
+        while (p < end && *p != ',') p++;
+        const char* t = p;
+        while (t > b && is_blank(t[-1])) t--;
+        tok_begin[n] = b;
+        tok_end[n] = t;
+        n++;
+        if (p == end) break;
+        p++;
+    }
+
+    if (n < SCENE_FIELDS_MIN) {
+        set_error(err, line, 0, "too few fields");
+        return false;
+    }
+
+    ShapeType type;
+    if (!parse_shape(tok_begin[0], tok_end[0], &type)) {
+        set_error(err, line, 1, "unknown shape, expected point, sphere, cylinder or cube");
+        return false;
+    }
+
+
+    double v[SCENE_FIELDS_MAX] = {0.0};
+    for (int i = 2; i < n; i++) {
+        if (i == 14 || i == 15) continue;
+        if (i >= SCENE_FIELDS_MIN && tok_begin[i] == tok_end[i]) continue;
+        if (!parse_double(tok_begin[i], tok_end[i], &v[i])) {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "invalid number in field '%s'", field_names[i]);
+            set_error(err, line, i + 1, msg);
+            return false;
+        }
+    }
+
+    bool rigid, is_static;
+    if (!parse_bool(tok_begin[14], tok_end[14], &rigid)) {
+        set_error(err, line, 15, "invalid boolean in field 'rigid'");
+        return false;
+    }
+    if (!parse_bool(tok_begin[15], tok_end[15], &is_static)) {
+        set_error(err, line, 16, "invalid boolean in field 'static'");
+        return false;
+    }
+
+    double radius = v[16], height = v[17], width = v[18];
+    if ((type == SHAPE_SPHERE || type == SHAPE_CYLINDER) && !(radius > 0.0)) {
+        set_error(err, line, 17, "shape requires a positive radius");
+        return false;
+    }
+    if ((type == SHAPE_CYLINDER || type == SHAPE_CUBE) && !(height > 0.0)) {
+        set_error(err, line, 18, "shape requires a positive height");
+        return false;
+    }
+    if (type == SHAPE_CUBE && !(width > 0.0)) {
+        set_error(err, line, 19, "shape requires a positive width");
+        return false;
+    }
+
+    Vector pos = {v[4], v[5], v[6]};
+    Vector vel = {v[7], v[8], v[9]};
+    Vector acc = {v[10], v[11], v[12]};
+    *e = new_entity(NULL, v[2], v[3], &pos, &vel, &acc, v[13], rigid, is_static);
+
+    // interned straight from the mapped file, names keep the 255 character limit of the format
+    size_t name_len = (size_t)(tok_end[1] - tok_begin[1]);
+    if (name_len > SCENE_NAME_MAX) name_len = SCENE_NAME_MAX;
+    if (name_registry_intern_n(name_registry_default(), tok_begin[1], name_len, &e->name_id) !=
+        NAME_REGISTRY_SUCCESS) {
+        set_error(err, line, 2, "out of memory interning the name");
+        return false;
+    }
+
+    if (shape) {
+        shape->type = type;
+        shape->radius = radius;
+        shape->height = height;
+        shape->width = width;
+    }
+    return true;
+}
+
+static bool is_record(const char* p, const char* end) {
+    while (p < end && is_blank(*p)) p++;
+    return p < end && *p != '#';
+}
+
+static void scan_chunk(SceneChunk* c) {
+    size_t records = 0, lines = 0;
+    const char* p = c->begin;
+    while (p < c->end) {
+        const char* nl = memchr(p, '\n', (size_t)(c->end - p));
+        const char* line_end = nl ? nl : c->end;
+        if (is_record(p, line_end)) records++;
+        lines++;
+        p = nl ? nl + 1 : c->end;
+    }
+    c->records = records;
+    c->lines = lines;
+}
+
+static void parse_chunk(SceneChunk* c, Entity* entities, SceneShape* shapes) {
+    size_t index = c->first_record;
+    size_t line = c->first_line;
+    const char* p = c->begin;
+    while (p < c->end) {
+        const char* nl = memchr(p, '\n', (size_t)(c->end - p));
+        const char* line_end = nl ? nl : c->end;
+        if (is_record(p, line_end)) {
+            if (!parse_record(p, line_end, line, &entities[index], shapes ? &shapes[index] : NULL, &c->error)) {
+                c->records = index - c->first_record;
+                c->failed = true;
+                return;
+            }
+            index++;
+        }
+        line++;
+        p = nl ? nl + 1 : c->end;
+    }
+}
+
+/**
+ * Split data into chunks that start right after a newline.
+ */
+static SceneChunk* split_chunks(const char* data, size_t size, int* chunk_count) {
+    int n = 1;
+#ifdef _OPENMP
+    n = omp_get_max_threads() * 4;
+#endif
+    if ((size_t)n > size / SCENE_MIN_CHUNK) n = (int)(size / SCENE_MIN_CHUNK);
+    if (n < 1) n = 1;
+
+    SceneChunk* chunks = calloc((size_t)n, sizeof(SceneChunk));
+    if (!chunks) return NULL;
+
+    const char* end = data + size;
+    const char* p = data;
+    for (int i = 0; i < n; i++) {
+        chunks[i].begin = p;
+        const char* q = i == n - 1 ? end : data + size / n * (i + 1);
+        if (q < p) q = p;
+        if (q < end) {
+            const char* nl = memchr(q, '\n', (size_t)(end - q));
+            q = nl ? nl + 1 : end;
+        }
+        chunks[i].end = q;
+        p = q;
+    }
+
+    *chunk_count = n;
+    return chunks;
+}
+
+static SceneErrorCode scan_buffer(const char* data, size_t size, SceneChunk** out_chunks, int* out_n,
+                                  size_t* total) {
+    int n = 0;
+    SceneChunk* chunks = split_chunks(data, size, &n);
+    if (!chunks) return SCENE_ERROR_CAPACITY;
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        scan_chunk(&chunks[i]);
+    }
+
+    size_t records = 0, lines = 1;
+    for (int i = 0; i < n; i++) {
+        chunks[i].first_record = records;
+        chunks[i].first_line = lines;
+        records += chunks[i].records;
+        lines += chunks[i].lines;
+    }
+
+    *out_chunks = chunks;
+    *out_n = n;
+    *total = records;
+    return SCENE_SUCCESS;
+}
+
+SceneErrorCode scene_parse_buffer(const char* data, size_t size, Entity* entities, SceneShape* shapes,
+                                  size_t capacity, size_t* count, SceneLoadError* error) {
+    if (!data || !entities || !count) {
+        return SCENE_ERROR_NULL_POINTER;
+    }
+
+    SceneChunk* chunks;
+    int n;
+    size_t total;
+    SceneErrorCode rc = scan_buffer(data, size, &chunks, &n, &total);
+    if (rc != SCENE_SUCCESS) return rc;
+
+    if (total > capacity) {
+        free(chunks);
+        *count = total;
+        return SCENE_ERROR_CAPACITY;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int i = 0; i < n; i++) {
+        parse_chunk(&chunks[i], entities, shapes);
+    }
+
+    rc = SCENE_SUCCESS;
+    *count = total;
+    for (int i = 0; i < n; i++) {
+        if (chunks[i].failed) {
+            // chunks are in file order, the first failing one holds the earliest line
+            if (error) *error = chunks[i].error;
+            *count = chunks[i].first_record + chunks[i].records;
+            rc = SCENE_ERROR_PARSE;
+            break;
+        }
+    }
+
+    free(chunks);
+    return rc;
+}
+
+typedef struct SceneFile {
+    const char* data;
+    size_t size;
+    bool mapped;
+} SceneFile;
+
+static SceneErrorCode scene_file_open(const char* path, SceneFile* f) {
+    f->data = NULL;
+    f->size = 0;
+    f->mapped = false;
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return SCENE_ERROR_IO;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return SCENE_ERROR_IO;
+    }
+    f->size = (size_t)st.st_size;
+    if (f->size == 0) {
+        close(fd);
+        return SCENE_SUCCESS;
+    }
+    void* p = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return SCENE_ERROR_IO;
+    madvise(p, f->size, MADV_SEQUENTIAL);
+    f->data = p;
+    f->mapped = true;
+    return SCENE_SUCCESS;
+#else
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return SCENE_ERROR_IO;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(fp);
+        return SCENE_ERROR_IO;
+    }
+    char* buf = malloc((size_t)size + 1);
+    if (!buf) {
+        fclose(fp);
+        return SCENE_ERROR_CAPACITY;
+    }
+    f->size = fread(buf, 1, (size_t)size, fp);
+    fclose(fp);
+    f->data = buf;
+    return SCENE_SUCCESS;
+#endif
+}
+
+static void scene_file_close(SceneFile* f) {
+#ifndef _WIN32
+    if (f->mapped) munmap((void*)f->data, f->size);
+#else
+    free((void*)f->data);
+#endif
+}
+
+SceneErrorCode scene_count_records(const char* path, size_t* count) {
+    if (!path || !count) {
+        return SCENE_ERROR_NULL_POINTER;
+    }
+
+    SceneFile f;
+    SceneErrorCode rc = scene_file_open(path, &f);
+    if (rc != SCENE_SUCCESS) return rc;
+
+    *count = 0;
+    if (f.size > 0) {
+        SceneChunk* chunks;
+        int n;
+        rc = scan_buffer(f.data, f.size, &chunks, &n, count);
+        if (rc == SCENE_SUCCESS) free(chunks);
+    }
+
+    scene_file_close(&f);
+    return rc;
+}
+
+SceneErrorCode scene_load(const char* path, Entity* entities, SceneShape* shapes, size_t capacity,
+                          size_t* count, SceneLoadError* error) {
+    if (!path || !entities || !count) {
+        return SCENE_ERROR_NULL_POINTER;
+    }
+
+    SceneFile f;
+    SceneErrorCode rc = scene_file_open(path, &f);
+    if (rc != SCENE_SUCCESS) {
+        if (error) set_error(error, 0, 0, "cannot open scene file");
+        return rc;
+    }
+
+    *count = 0;
+    if (f.size > 0) {
+        rc = scene_parse_buffer(f.data, f.size, entities, shapes, capacity, count, error);
+    }
+
+    scene_file_close(&f);
+    return rc;
+}
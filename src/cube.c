@@ -3,4 +3,9 @@
 //
 
 #include "../include/basic_obj/cube.h"
+
+SceneShape cube_shape(const Cube* c) {
+    SceneShape shape = {SHAPE_CUBE, 0.0, c->height, c->width};
+    return shape;
+}
 #
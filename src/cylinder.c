@@ -7,4 +7,9 @@ Cylinder* new_cylinder(Entity e, double h, double r) {
     cy -> height = h;
     cy -> radius = r;
     return cy;
+}
+
+SceneShape cylinder_shape(const Cylinder* c) {
+    SceneShape shape = {SHAPE_CYLINDER, c->radius, c->height, 0.0};
+    return shape;
 }
\ No newline at end of file
@@ -5,4 +5,47 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
-#include "../../include/graphics/camera.h"
\ No newline at end of file
+#include "../../include/graphics/camera.h"
+#include "../../include/mathlib/vec_math.h"
+
+Camera new_camera(const Vector* eye, const Vector* target, const Vector* up, double fov_y) {
+    Camera cam;
+    cam.fov_y = fov_y;
+    cam.near_plane = 1e-3;
+    if (camera_look_at(&cam, eye, target, up) != OPERATION_SET_SUCCESS) {
+        Vector origin = {0.0, 0.0, 0.0};
+        Vector forward = {0.0, 0.0, 1.0};
+        Vector y_up = {0.0, 1.0, 0.0};
+        camera_look_at(&cam, &origin, &forward, &y_up);
+    }
+    return cam;
+}
+
+ErrorCode camera_look_at(Camera* cam, const Vector* eye, const Vector* target, const Vector* up) {
+    if (!cam || !eye || !target || !up) {
+        return OPERATION_SET_FAILED;
+    }
+
+    double len;
+    Vector forward = vec3_normalize(vec3_sub(*target, *eye), &len);
+    if (len < 1e-12) {
+        return DIVISION_BY_ZERO;
+    }
+
+    Vector right = vec3_normalize(vec3_cross(forward, *up), &len);
+    if (len < 1e-12) {
+        return DIVISION_BY_ZERO;
+    }
+
+    cam->position = *eye;
+    cam->forward = forward;
+    cam->right = right;
+    cam->up = vec3_cross(right, forward);
+
+    return OPERATION_SET_SUCCESS;
+}
+
+Vector camera_to_view(const Camera* cam, const Vector* p) {
+    Vector d = vec3_sub(*p, cam->position);
+    return vec3(vec3_dot(d, cam->right), vec3_dot(d, cam->up), vec3_dot(d, cam->forward));
+}
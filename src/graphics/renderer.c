@@ -0,0 +1,680 @@
+#include "../../include/graphics/renderer.h"
+#include "../../include/core/movement.h"
+#include "../../include/core/time_flow.h"
+#include "../../include/mathlib/vec_math.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <stdint.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+typedef enum {
+    PRIM_SPHERE,
+    PRIM_CYLINDER,
+    PRIM_BOX
+} PrimKind;
+
+struct RenderPrim {
+    int kind;
+    Vector center;      // view space
+    Vector axis[3];     // body local axes in view space
+    double radius;
+    double half_height;
+    double half_width;
+    float z_min;
+    int x0, y0, x1, y1; // inclusive pixel bounds, x1 < x0 when culled
+};
+
+static const unsigned char prim_colors[3][3] = {
+    {230, 120, 60},
+    {80, 170, 230},
+    {120, 210, 110}
+};
+
+ErrorCode renderer_init(Renderer* r, int width, int height, int tile_size) {
+    if (!r || width <= 0 || height <= 0) {
+        return OPERATION_SET_FAILED;
+    }
+    memset(r, 0, sizeof(*r));
+
+    r->tile_size = tile_size > 0 ? tile_size : 32;
+    r->tiles_x = (width + r->tile_size - 1) / r->tile_size;
+    r->tiles_y = (height + r->tile_size - 1) / r->tile_size;
+    r->fb.width = width;
+    r->fb.height = height;
+    r->fb.rgb = malloc((size_t)width * height * 3);
+    r->fb.depth = malloc((size_t)width * height * sizeof(float));
+    r->tile_offsets = malloc(((size_t)r->tiles_x * r->tiles_y + 1) * sizeof(size_t));
+
+    if (!r->fb.rgb || !r->fb.depth || !r->tile_offsets) {
+        renderer_free(r);
+        return OPERATION_SET_FAILED;
+    }
+
+    r->background[0] = 20;
+    r->background[1] = 20;
+    r->background[2] = 28;
+    renderer_clear(r);
+
+    return OPERATION_SET_SUCCESS;
+}
+
+void renderer_free(Renderer* r) {
+    if (!r) return;
+    free(r->fb.rgb);
+    free(r->fb.depth);
+    free(r->prims);
+    free(r->tile_offsets);
+    free(r->tile_items);
+    free(r->sort_keys);
+    memset(r, 0, sizeof(*r));
+}
+
+void renderer_clear(Renderer* r) {
+    size_t pixels = (size_t)r->fb.width * r->fb.height;
+    for (size_t i = 0; i < pixels; i++) {
+        r->fb.rgb[3*i]     = r->background[0];
+        r->fb.rgb[3*i + 1] = r->background[1];
+        r->fb.rgb[3*i + 2] = r->background[2];
+        r->fb.depth[i] = FLT_MAX;
+    }
+}
+
+static Vector to_view_direction(const Camera* cam, const Vector* v) {
+    return vec3(vec3_dot(*v, cam->right), vec3_dot(*v, cam->up), vec3_dot(*v, cam->forward));
+}
+
+static void setup_prim(struct RenderPrim* p, int kind, const Entity* e, double radius, double half_height,
+                       double half_width, const Camera* cam, double sx, double sy, int width, int height) {
+    static const Vector unit[3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+
+    p->kind = kind;
+    p->radius = radius;
+    p->half_height = half_height;
+    p->half_width = half_width;
+    p->center = camera_to_view(cam, &e->position);
+    p->x0 = 0;
+    p->x1 = -1;
+
+    double bound;
+    switch (kind) {
+        case PRIM_CYLINDER:
+            bound = sqrt(radius*radius + half_height*half_height);
+            break;
+        case PRIM_BOX:
+            bound = sqrt(2.0*half_width*half_width + half_height*half_height);
+            break;
+        default:
+            bound = radius;
+            break;
+    }
+
+    double cx = p->center.x, cy = p->center.y, cz = p->center.z;
+    if (cz + bound <= cam->near_plane) {
+        return;
+    }
+
+    if (kind != PRIM_SPHERE) {
+        for (int i = 0; i < 3; i++) {
+            Vector world_axis;
+            rotate_vector_by_quaternion(&unit[i], e->quaternion, &world_axis);
+            p->axis[i] = to_view_direction(cam, &world_axis);
+        }
+    }
+
+    double min_x, max_x, min_y, max_y;
+    if (cz - bound <= cam->near_plane) {
+        // straddles the near plane, cover the whole screen
+        p->z_min = (float)cam->near_plane;
+        min_x = -sx; max_x = sx;
+        min_y = -sy; max_y = sy;
+    } else {
+        // slopes over the corners of the bounding box contain the projected bounding sphere
+        double z_near = cz - bound, z_far = cz + bound;
+        double xs[4] = {(cx - bound) / z_near, (cx - bound) / z_far, (cx + bound) / z_near, (cx + bound) / z_far};
+        double ys[4] = {(cy - bound) / z_near, (cy - bound) / z_far, (cy + bound) / z_near, (cy + bound) / z_far};
+        min_x = max_x = xs[0];
+        min_y = max_y = ys[0];
+        for (int i = 1; i < 4; i++) {
+            if (xs[i] < min_x) min_x = xs[i];
+            if (xs[i] > max_x) max_x = xs[i];
+            if (ys[i] < min_y) min_y = ys[i];
+            if (ys[i] > max_y) max_y = ys[i];
+        }
+        p->z_min = (float)z_near;
+    }
+
+    double fx0 = (min_x / sx + 1.0) * 0.5 * width - 0.5;
+    double fx1 = (max_x / sx + 1.0) * 0.5 * width - 0.5;
+    double fy0 = (1.0 - max_y / sy) * 0.5 * height - 0.5;
+    double fy1 = (1.0 - min_y / sy) * 0.5 * height - 0.5;
+
+    if (fx1 < 0.0 || fy1 < 0.0 || fx0 > width - 1 || fy0 > height - 1) {
+        return;
+    }
+
+    p->x0 = fx0 < 0.0 ? 0 : (int)floor(fx0);
+    p->y0 = fy0 < 0.0 ? 0 : (int)floor(fy0);
+    p->x1 = fx1 > width - 1 ? width - 1 : (int)ceil(fx1);
+    p->y1 = fy1 > height - 1 ? height - 1 : (int)ceil(fy1);
+}
+
+static bool intersect_sphere(const struct RenderPrim* p, const Vector* d, double near_plane,
+                             double* t_out, Vector* n_out) {
+    const Vector* c = &p->center;
+    double a = d->x*d->x + d->y*d->y + d->z*d->z;
+    double b = d->x*c->x + d->y*c->y + d->z*c->z;
+    double cc = c->x*c->x + c->y*c->y + c->z*c->z - p->radius * p->radius;
+    double disc = b*b - a*cc;
+    if (disc < 0.0) return false;
+
+    double s = sqrt(disc);
+    double t = (b - s) / a;
+    if (t < near_plane) {
+        t = (b + s) / a;
+        if (t < near_plane) return false;
+    }
+
+    double inv_r = 1.0 / p->radius;
+    n_out->x = (t*d->x - c->x) * inv_r;
+    n_out->y = (t*d->y - c->y) * inv_r;
+    n_out->z = (t*d->z - c->z) * inv_r;
+    *t_out = t;
+    return true;
+}
+
+static void to_local(const struct RenderPrim* p, const Vector* d, double o[3], double dl[3]) {
+    const Vector* c = &p->center;
+    for (int i = 0; i < 3; i++) {
+        const Vector* ax = &p->axis[i];
+        o[i] = -(c->x*ax->x + c->y*ax->y + c->z*ax->z);
+        dl[i] = d->x*ax->x + d->y*ax->y + d->z*ax->z;
+    }
+}
+
+static bool intersect_box(const struct RenderPrim* p, const Vector* d, double near_plane,
+                          double* t_out, Vector* n_out) {
+    double o[3], dl[3];
+    double h[3] = {p->half_width, p->half_height, p->half_width};
+    to_local(p, d, o, dl);
+
+    double t_min = -DBL_MAX, t_max = DBL_MAX;
+    int hit_axis = 0;
+    double hit_sign = 1.0;
+    for (int i = 0; i < 3; i++) {
+        if (fabs(dl[i]) < 1e-12) {
+            if (fabs(o[i]) > h[i]) return false;
+            continue;
+        }
+        double inv = 1.0 / dl[i];
+        double t1 = (-h[i] - o[i]) * inv;
+        double t2 = (h[i] - o[i]) * inv;
+        if (t1 > t2) {
+            double tmp = t1; t1 = t2; t2 = tmp;
+        }
+        if (t1 > t_min) {
+            t_min = t1;
+            hit_axis = i;
+            hit_sign = dl[i] > 0.0 ? -1.0 : 1.0;
+        }
+        if (t2 < t_max) t_max = t2;
+        if (t_min > t_max) return false;
+    }
+    if (t_min < near_plane) return false;
+
+    n_out->x = hit_sign * p->axis[hit_axis].x;
+    n_out->y = hit_sign * p->axis[hit_axis].y;
+    n_out->z = hit_sign * p->axis[hit_axis].z;
+    *t_out = t_min;
+    return true;
+}
+
+static bool intersect_cylinder(const struct RenderPrim* p, const Vector* d, double near_plane,
+                               double* t_out, Vector* n_out) {
+    double o[3], dl[3];
+    double r = p->radius, hh = p->half_height;
+    to_local(p, d, o, dl);
+
+    double best = DBL_MAX;
+    double a = dl[0]*dl[0] + dl[2]*dl[2];
+    if (a > 1e-12) {
+        double b = o[0]*dl[0] + o[2]*dl[2];
+        double cc = o[0]*o[0] + o[2]*o[2] - r*r;
+        double disc = b*b - a*cc;
+        if (disc >= 0.0) {
+            double t = (-b - sqrt(disc)) / a;
+            double y = o[1] + t*dl[1];
+            if (t >= near_plane && fabs(y) <= hh) {
+                double lx = (o[0] + t*dl[0]) / r;
+                double lz = (o[2] + t*dl[2]) / r;
+                best = t;
+                n_out->x = lx*p->axis[0].x + lz*p->axis[2].x;
+                n_out->y = lx*p->axis[0].y + lz*p->axis[2].y;
+                n_out->z = lx*p->axis[0].z + lz*p->axis[2].z;
+            }
+        }
+    }
+
+    if (fabs(dl[1]) > 1e-12) {
+        for (int s = -1; s <= 1; s += 2) {
+            double t = (s*hh - o[1]) / dl[1];
+            if (t < near_plane || t >= best) continue;
+            double x = o[0] + t*dl[0];
+            double z = o[2] + t*dl[2];
+            if (x*x + z*z <= r*r) {
+                best = t;
+                n_out->x = s * p->axis[1].x;
+                n_out->y = s * p->axis[1].y;
+                n_out->z = s * p->axis[1].z;
+            }
+        }
+    }
+
+    if (best == DBL_MAX) return false;
+    *t_out = best;
+    return true;
+}
+
+static void raster_tile(Renderer* r, int tile, double sx, double sy, double near_plane, bool clear) {
+    Framebuffer* fb = &r->fb;
+    int tx = tile % r->tiles_x, ty = tile / r->tiles_x;
+    int x0 = tx * r->tile_size, y0 = ty * r->tile_size;
+    int x1 = x0 + r->tile_size - 1, y1 = y0 + r->tile_size - 1;
+    if (x1 >= fb->width) x1 = fb->width - 1;
+    if (y1 >= fb->height) y1 = fb->height - 1;
+
+    if (clear) {
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                size_t idx = (size_t)y * fb->width + x;
+                fb->rgb[3*idx]     = r->background[0];
+                fb->rgb[3*idx + 1] = r->background[1];
+                fb->rgb[3*idx + 2] = r->background[2];
+                fb->depth[idx] = FLT_MAX;
+            }
+        }
+    }
+
+    double px_scale = 2.0 * sx / fb->width;
+    double py_scale = 2.0 * sy / fb->height;
+
+    for (size_t k = r->tile_offsets[tile]; k < r->tile_offsets[tile + 1]; k++) {
+        const struct RenderPrim* p = &r->prims[r->tile_items[k]];
+        int ix0 = p->x0 > x0 ? p->x0 : x0;
+        int ix1 = p->x1 < x1 ? p->x1 : x1;
+        int iy0 = p->y0 > y0 ? p->y0 : y0;
+        int iy1 = p->y1 < y1 ? p->y1 : y1;
+        const unsigned char* color = prim_colors[p->kind];
+
+        for (int y = iy0; y <= iy1; y++) {
+            Vector d;
+            d.y = sy - (y + 0.5) * py_scale;
+            d.z = 1.0;
+            for (int x = ix0; x <= ix1; x++) {
+                size_t idx = (size_t)y * fb->width + x;
+                if (p->z_min >= fb->depth[idx]) continue;
+
+                d.x = (x + 0.5) * px_scale - sx;
+                double t;
+                Vector n;
+                bool hit;
+                switch (p->kind) {
+                    case PRIM_CYLINDER:
+                        hit = intersect_cylinder(p, &d, near_plane, &t, &n);
+                        break;
+                    case PRIM_BOX:
+                        hit = intersect_box(p, &d, near_plane, &t, &n);
+                        break;
+                    default:
+                        hit = intersect_sphere(p, &d, near_plane, &t, &n);
+                        break;
+                }
+                if (!hit || t >= fb->depth[idx]) continue;
+
+                // headlight shading
+                double facing = -(n.x*d.x + n.y*d.y + n.z*d.z) / sqrt(d.x*d.x + d.y*d.y + 1.0);
+                double shade = 0.15 + 0.85 * (facing > 0.0 ? facing : 0.0);
+                fb->rgb[3*idx]     = (unsigned char)(color[0] * shade);
+                fb->rgb[3*idx + 1] = (unsigned char)(color[1] * shade);
+                fb->rgb[3*idx + 2] = (unsigned char)(color[2] * shade);
+                fb->depth[idx] = (float)t;
+            }
+        }
+    }
+}
+
+/**
+ * @brief LSD radix sort of (depth bits << 32 | index) keys on the depth half, returns the sorted buffer
+ *
+ * z_min is positive so its IEEE bits order like the float values.
+ */
+static uint64_t* sort_by_depth(uint64_t* keys, uint64_t* scratch, size_t n) {
+    size_t count[256];
+    for (int shift = 32; shift < 64; shift += 8) {
+        memset(count, 0, sizeof(count));
+        for (size_t i = 0; i < n; i++) {
+            count[(keys[i] >> shift) & 0xff]++;
+        }
+        size_t sum = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            scratch[count[(keys[i] >> shift) & 0xff]++] = keys[i];
+        }
+        uint64_t* tmp = keys;
+        keys = scratch;
+        scratch = tmp;
+    }
+    return keys;
+}
+
+ErrorCode renderer_draw(Renderer* r, const Camera* cam, const RenderScene* scene, bool clear) {
+    if (!r || !cam || !scene || !r->fb.rgb) {
+        return OPERATION_SET_FAILED;
+    }
+
+    double t_start = wall_clock_ms();
+    Framebuffer* fb = &r->fb;
+    size_t total = scene->sphere_count + scene->cylinder_count + scene->cube_count;
+    int tile_count = r->tiles_x * r->tiles_y;
+
+    if (total > r->prim_capacity) {
+        struct RenderPrim* prims = realloc(r->prims, total * sizeof(struct RenderPrim));
+        if (!prims) return OPERATION_SET_FAILED;
+        r->prims = prims;
+        r->prim_capacity = total;
+    }
+
+    double sy = tan(cam->fov_y * 0.5);
+    double sx = sy * (double)fb->width / fb->height;
+
+    long n_spheres = (long)scene->sphere_count;
+    long n_cylinders = (long)scene->cylinder_count;
+    long n_cubes = (long)scene->cube_count;
+
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < n_spheres; i++) {
+        const Sphere* s = &scene->spheres[i];
+        setup_prim(&r->prims[i], PRIM_SPHERE, &s->ent, s->radius, 0.0, 0.0, cam, sx, sy, fb->width, fb->height);
+    }
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < n_cylinders; i++) {
+        const Cylinder* c = &scene->cylinders[i];
+        setup_prim(&r->prims[n_spheres + i], PRIM_CYLINDER, &c->ent, c->radius, 0.5 * c->height, 0.0,
+                   cam, sx, sy, fb->width, fb->height);
+    }
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < n_cubes; i++) {
+        const Cube* c = &scene->cubes[i];
+        setup_prim(&r->prims[n_spheres + n_cylinders + i], PRIM_BOX, &c->ent, 0.0, 0.5 * c->height, 0.5 * c->width,
+                   cam, sx, sy, fb->width, fb->height);
+    }
+
+    double t_setup = wall_clock_ms();
+
+    // front to back order lets the per pixel z_min test reject hidden bodies before intersecting
+    if (total > r->sort_capacity) {
+        uint64_t* keys = realloc(r->sort_keys, 2 * total * sizeof(uint64_t));
+        if (!keys) return OPERATION_SET_FAILED;
+        r->sort_keys = keys;
+        r->sort_capacity = total;
+    }
+    size_t visible = 0;
+    for (size_t i = 0; i < total; i++) {
+        const struct RenderPrim* p = &r->prims[i];
+        if (p->x1 < p->x0) continue;
+        uint32_t bits;
+        memcpy(&bits, &p->z_min, sizeof(bits));
+        r->sort_keys[visible++] = ((uint64_t)bits << 32) | (uint32_t)i;
+    }
+    uint64_t* order = sort_by_depth(r->sort_keys, r->sort_keys + total, visible);
+
+    // counting sort of tile references
+    size_t* offsets = r->tile_offsets;
+    memset(offsets, 0, ((size_t)tile_count + 1) * sizeof(size_t));
+    for (size_t k = 0; k < visible; k++) {
+        const struct RenderPrim* p = &r->prims[(uint32_t)order[k]];
+        for (int ty = p->y0 / r->tile_size; ty <= p->y1 / r->tile_size; ty++) {
+            for (int tx = p->x0 / r->tile_size; tx <= p->x1 / r->tile_size; tx++) {
+                offsets[ty * r->tiles_x + tx + 1]++;
+            }
+        }
+    }
+    for (int t = 0; t < tile_count; t++) {
+        offsets[t + 1] += offsets[t];
+    }
+
+    size_t refs = offsets[tile_count];
+    if (refs > r->item_capacity) {
+        size_t* items = realloc(r->tile_items, refs * sizeof(size_t));
+        if (!items) return OPERATION_SET_FAILED;
+        r->tile_items = items;
+        r->item_capacity = refs;
+    }
+
+    // offsets[t] is used as the fill cursor of tile t and ends up at the start of tile t + 1
+    for (size_t k = 0; k < visible; k++) {
+        uint32_t i = (uint32_t)order[k];
+        const struct RenderPrim* p = &r->prims[i];
+        for (int ty = p->y0 / r->tile_size; ty <= p->y1 / r->tile_size; ty++) {
+            for (int tx = p->x0 / r->tile_size; tx <= p->x1 / r->tile_size; tx++) {
+                r->tile_items[offsets[ty * r->tiles_x + tx]++] = i;
+            }
+        }
+    }
+    memmove(offsets + 1, offsets, (size_t)tile_count * sizeof(size_t));
+    offsets[0] = 0;
+
+    double t_bin = wall_clock_ms();
+
+    double near_plane = cam->near_plane;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int t = 0; t < tile_count; t++) {
+        raster_tile(r, t, sx, sy, near_plane, clear);
+    }
+
+    double t_end = wall_clock_ms();
+
+    r->stats.setup_ms = t_setup - t_start;
+    r->stats.binning_ms = t_bin - t_setup;
+    r->stats.raster_ms = t_end - t_bin;
+    r->stats.frame_ms = t_end - t_start;
+    r->stats.visible_bodies = visible;
+    r->stats.tile_refs = refs;
+    r->stats.tile_count = tile_count;
+#ifdef _OPENMP
+    r->stats.threads = omp_get_max_threads();
+#else
+    r->stats.threads = 1;
+#endif
+
+    return OPERATION_SET_SUCCESS;
+}
+
+ErrorCode framebuffer_write_ppm(const Framebuffer* fb, const char* path) {
+    if (!fb || !fb->rgb || !path) {
+        return OPERATION_GET_FAILED;
+    }
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return OPERATION_GET_FAILED;
+
+    size_t bytes = (size_t)fb->width * fb->height * 3;
+    fprintf(f, "P6\n%d %d\n255\n", fb->width, fb->height);
+    size_t written = fwrite(fb->rgb, 1, bytes, f);
+    fclose(f);
+
+    return written == bytes ? OPERATION_GET_SUCCESS : OPERATION_GET_FAILED;
+}
+
+// CRC-32 (polynomial 0xedb88320) of every byte value, as used by PNG chunks
+static const unsigned long crc_table[256] = {
+    0x00000000UL, 0x77073096UL, 0xee0e612cUL, 0x990951baUL, 0x076dc419UL, 0x706af48fUL,
+    0xe963a535UL, 0x9e6495a3UL, 0x0edb8832UL, 0x79dcb8a4UL, 0xe0d5e91eUL, 0x97d2d988UL,
+    0x09b64c2bUL, 0x7eb17cbdUL, 0xe7b82d07UL, 0x90bf1d91UL, 0x1db71064UL, 0x6ab020f2UL,
+    0xf3b97148UL, 0x84be41deUL, 0x1adad47dUL, 0x6ddde4ebUL, 0xf4d4b551UL, 0x83d385c7UL,
+    0x136c9856UL, 0x646ba8c0UL, 0xfd62f97aUL, 0x8a65c9ecUL, 0x14015c4fUL, 0x63066cd9UL,
+    0xfa0f3d63UL, 0x8d080df5UL, 0x3b6e20c8UL, 0x4c69105eUL, 0xd56041e4UL, 0xa2677172UL,
+    0x3c03e4d1UL, 0x4b04d447UL, 0xd20d85fdUL, 0xa50ab56bUL, 0x35b5a8faUL, 0x42b2986cUL,
+    0xdbbbc9d6UL, 0xacbcf940UL, 0x32d86ce3UL, 0x45df5c75UL, 0xdcd60dcfUL, 0xabd13d59UL,
+    0x26d930acUL, 0x51de003aUL, 0xc8d75180UL, 0xbfd06116UL, 0x21b4f4b5UL, 0x56b3c423UL,
+    0xcfba9599UL, 0xb8bda50fUL, 0x2802b89eUL, 0x5f058808UL, 0xc60cd9b2UL, 0xb10be924UL,
+    0x2f6f7c87UL, 0x58684c11UL, 0xc1611dabUL, 0xb6662d3dUL, 0x76dc4190UL, 0x01db7106UL,
+    0x98d220bcUL, 0xefd5102aUL, 0x71b18589UL, 0x06b6b51fUL, 0x9fbfe4a5UL, 0xe8b8d433UL,
+    0x7807c9a2UL, 0x0f00f934UL, 0x9609a88eUL, 0xe10e9818UL, 0x7f6a0dbbUL, 0x086d3d2dUL,
+    0x91646c97UL, 0xe6635c01UL, 0x6b6b51f4UL, 0x1c6c6162UL, 0x856530d8UL, 0xf262004eUL,
+    0x6c0695edUL, 0x1b01a57bUL, 0x8208f4c1UL, 0xf50fc457UL, 0x65b0d9c6UL, 0x12b7e950UL,
+    0x8bbeb8eaUL, 0xfcb9887cUL, 0x62dd1ddfUL, 0x15da2d49UL, 0x8cd37cf3UL, 0xfbd44c65UL,
+    0x4db26158UL, 0x3ab551ceUL, 0xa3bc0074UL, 0xd4bb30e2UL, 0x4adfa541UL, 0x3dd895d7UL,
+    0xa4d1c46dUL, 0xd3d6f4fbUL, 0x4369e96aUL, 0x346ed9fcUL, 0xad678846UL, 0xda60b8d0UL,
+    0x44042d73UL, 0x33031de5UL, 0xaa0a4c5fUL, 0xdd0d7cc9UL, 0x5005713cUL, 0x270241aaUL,
+    0xbe0b1010UL, 0xc90c2086UL, 0x5768b525UL, 0x206f85b3UL, 0xb966d409UL, 0xce61e49fUL,
+    0x5edef90eUL, 0x29d9c998UL, 0xb0d09822UL, 0xc7d7a8b4UL, 0x59b33d17UL, 0x2eb40d81UL,
+    0xb7bd5c3bUL, 0xc0ba6cadUL, 0xedb88320UL, 0x9abfb3b6UL, 0x03b6e20cUL, 0x74b1d29aUL,
+    0xead54739UL, 0x9dd277afUL, 0x04db2615UL, 0x73dc1683UL, 0xe3630b12UL, 0x94643b84UL,
+    0x0d6d6a3eUL, 0x7a6a5aa8UL, 0xe40ecf0bUL, 0x9309ff9dUL, 0x0a00ae27UL, 0x7d079eb1UL,
+    0xf00f9344UL, 0x8708a3d2UL, 0x1e01f268UL, 0x6906c2feUL, 0xf762575dUL, 0x806567cbUL,
+    0x196c3671UL, 0x6e6b06e7UL, 0xfed41b76UL, 0x89d32be0UL, 0x10da7a5aUL, 0x67dd4accUL,
+    0xf9b9df6fUL, 0x8ebeeff9UL, 0x17b7be43UL, 0x60b08ed5UL, 0xd6d6a3e8UL, 0xa1d1937eUL,
+    0x38d8c2c4UL, 0x4fdff252UL, 0xd1bb67f1UL, 0xa6bc5767UL, 0x3fb506ddUL, 0x48b2364bUL,
+    0xd80d2bdaUL, 0xaf0a1b4cUL, 0x36034af6UL, 0x41047a60UL, 0xdf60efc3UL, 0xa867df55UL,
+    0x316e8eefUL, 0x4669be79UL, 0xcb61b38cUL, 0xbc66831aUL, 0x256fd2a0UL, 0x5268e236UL,
+    0xcc0c7795UL, 0xbb0b4703UL, 0x220216b9UL, 0x5505262fUL, 0xc5ba3bbeUL, 0xb2bd0b28UL,
+    0x2bb45a92UL, 0x5cb36a04UL, 0xc2d7ffa7UL, 0xb5d0cf31UL, 0x2cd99e8bUL, 0x5bdeae1dUL,
+    0x9b64c2b0UL, 0xec63f226UL, 0x756aa39cUL, 0x026d930aUL, 0x9c0906a9UL, 0xeb0e363fUL,
+    0x72076785UL, 0x05005713UL, 0x95bf4a82UL, 0xe2b87a14UL, 0x7bb12baeUL, 0x0cb61b38UL,
+    0x92d28e9bUL, 0xe5d5be0dUL, 0x7cdcefb7UL, 0x0bdbdf21UL, 0x86d3d2d4UL, 0xf1d4e242UL,
+    0x68ddb3f8UL, 0x1fda836eUL, 0x81be16cdUL, 0xf6b9265bUL, 0x6fb077e1UL, 0x18b74777UL,
+    0x88085ae6UL, 0xff0f6a70UL, 0x66063bcaUL, 0x11010b5cUL, 0x8f659effUL, 0xf862ae69UL,
+    0x616bffd3UL, 0x166ccf45UL, 0xa00ae278UL, 0xd70dd2eeUL, 0x4e048354UL, 0x3903b3c2UL,
+    0xa7672661UL, 0xd06016f7UL, 0x4969474dUL, 0x3e6e77dbUL, 0xaed16a4aUL, 0xd9d65adcUL,
+    0x40df0b66UL, 0x37d83bf0UL, 0xa9bcae53UL, 0xdebb9ec5UL, 0x47b2cf7fUL, 0x30b5ffe9UL,
+    0xbdbdf21cUL, 0xcabac28aUL, 0x53b39330UL, 0x24b4a3a6UL, 0xbad03605UL, 0xcdd70693UL,
+    0x54de5729UL, 0x23d967bfUL, 0xb3667a2eUL, 0xc4614ab8UL, 0x5d681b02UL, 0x2a6f2b94UL,
+    0xb40bbe37UL, 0xc30c8ea1UL, 0x5a05df1bUL, 0x2d02ef8dUL
+};
+
+static unsigned long update_crc(unsigned long crc, const unsigned char* buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc = crc_table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void put_be32(unsigned char* out, unsigned long v) {
+    out[0] = (unsigned char)(v >> 24);
+    out[1] = (unsigned char)(v >> 16);
+    out[2] = (unsigned char)(v >> 8);
+    out[3] = (unsigned char)v;
+}
+
+static void write_chunk_part(FILE* f, unsigned long* crc, const unsigned char* data, size_t len) {
+    fwrite(data, 1, len, f);
+    *crc = update_crc(*crc, data, len);
+}
+
+ErrorCode framebuffer_write_png(const Framebuffer* fb, const char* path) {
+    static const unsigned char signature[8] = {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+
+    if (!fb || !fb->rgb || !path) {
+        return OPERATION_GET_FAILED;
+    }
+
+    // filter byte 0 per scanline, image data stored uncompressed in deflate stored blocks
+    size_t row = (size_t)fb->width * 3;
+    size_t raw_size = (row + 1) * fb->height;
+    unsigned char* raw = malloc(raw_size);
+    if (!raw) return OPERATION_GET_FAILED;
+    for (int y = 0; y < fb->height; y++) {
+        raw[y * (row + 1)] = 0;
+        memcpy(raw + y * (row + 1) + 1, fb->rgb + y * row, row);
+    }
+
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        free(raw);
+        return OPERATION_GET_FAILED;
+    }
+
+    unsigned char buf[17];
+    unsigned long crc;
+    fwrite(signature, 1, sizeof(signature), f);
+
+    put_be32(buf, 13);
+    fwrite(buf, 1, 4, f);
+    memcpy(buf, "IHDR", 4);
+    put_be32(buf + 4, (unsigned long)fb->width);
+    put_be32(buf + 8, (unsigned long)fb->height);
+    buf[12] = 8;    // bit depth
+    buf[13] = 2;    // truecolor
+    buf[14] = 0;
+    buf[15] = 0;
+    buf[16] = 0;
+    crc = update_crc(0xffffffffUL, buf, 17);
+    fwrite(buf, 1, 17, f);
+    put_be32(buf, crc ^ 0xffffffffUL);
+    fwrite(buf, 1, 4, f);
+
+    size_t blocks = raw_size / 65535 + 1;
+    size_t idat_size = 2 + blocks * 5 + raw_size + 4;
+    put_be32(buf, (unsigned long)idat_size);
+    fwrite(buf, 1, 4, f);
+    crc = 0xffffffffUL;
+    write_chunk_part(f, &crc, (const unsigned char*)"IDAT", 4);
+    buf[0] = 0x78;
+    buf[1] = 0x01;
+    write_chunk_part(f, &crc, buf, 2);
+
+    unsigned long s1 = 1, s2 = 0;
+    size_t pos = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        size_t len = raw_size - pos < 65535 ? raw_size - pos : 65535;
+        buf[0] = b + 1 == blocks ? 1 : 0;
+        buf[1] = (unsigned char)(len & 0xff);
+        buf[2] = (unsigned char)(len >> 8);
+        buf[3] = (unsigned char)(~len & 0xff);
+        buf[4] = (unsigned char)((~len >> 8) & 0xff);
+        write_chunk_part(f, &crc, buf, 5);
+        write_chunk_part(f, &crc, raw + pos, len);
+        for (size_t i = 0; i < len; i++) {
+            s1 = (s1 + raw[pos + i]) % 65521;
+            s2 = (s2 + s1) % 65521;
+        }
+        pos += len;
+    }
+    put_be32(buf, (s2 << 16) | s1);
+    write_chunk_part(f, &crc, buf, 4);
+    put_be32(buf, crc ^ 0xffffffffUL);
+    fwrite(buf, 1, 4, f);
+
+    put_be32(buf, 0);
+    fwrite(buf, 1, 4, f);
+    memcpy(buf, "IEND", 4);
+    crc = update_crc(0xffffffffUL, buf, 4);
+    fwrite(buf, 1, 4, f);
+    put_be32(buf, crc ^ 0xffffffffUL);
+    fwrite(buf, 1, 4, f);
+
+    bool ok = !ferror(f);
+    fclose(f);
+    free(raw);
+
+    return ok ? OPERATION_GET_SUCCESS : OPERATION_GET_FAILED;
+}
+
+ErrorCode framebuffer_write_frame(const Framebuffer* fb, const char* prefix, int index, FrameFormat format) {
+    if (!prefix) {
+        return OPERATION_GET_FAILED;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s_%05d.%s", prefix, index, format == FRAME_FORMAT_PNG ? "png" : "ppm");
+
+    return format == FRAME_FORMAT_PNG ? framebuffer_write_png(fb, path) : framebuffer_write_ppm(fb, path);
+}
@@ -1,19 +1,16 @@
-#include "../../include/mathlib/Vector.h"
+#include "../../include/mathlib/vec_math.h"
+
+// out-of-line entry points kept for existing callers, new code should use the inline vec3_* functions
 
 double dot_product(const Vector a, const Vector b) {
-    return a.x*b.x + a.y*b.y + a.z*b.z;
+    return vec3_dot(a, b);
 }
 
 Vector cross_product(const Vector a, const Vector b) {
-    Vector result;
-    result.x = a.y * b.z - a.z * b.y;
-    result.y = a.z * b.x - a.x * b.z;
-    result.z = a.x * b.y - a.y * b.x;
-    return result;
+    return vec3_cross(a, b);
 }
 
 double normalize(const Vector a) {
-    double norm = sqrt(dot_product(a, a));
-    return norm;
+    return vec3_length(a);
 }
 
@@ -6,7 +6,7 @@
 
 char* show_entity_details(Entity* obj) {
     printf("=== Entity Details ===\n");
-    printf("Name: %s\n", obj->name);
+    printf("Name: %s\n", entity_name(obj));
     printf("Mass: %f\n", obj->mass);
     printf("Charge: %f\n", obj->charge);
     printf("Position: x: %f, y: %f, z: %f\n", obj->position.x, obj->position.y, obj->position.z);
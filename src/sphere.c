@@ -1,8 +1,19 @@
 #include "../include/basic_obj/sphere.h"
+#include "../include/graphics/renderer.h"
 #include <stdlib.h>
 Sphere* new_sphere(const Entity e, const double r){
     Sphere* ball = (malloc(sizeof(Sphere)));
     ball -> ent = e;
     ball -> radius = r;
     return ball;
-}
\ No newline at end of file
+}
+
+SceneShape sphere_shape(const Sphere* s) {
+    SceneShape shape = {SHAPE_SPHERE, s->radius, 0.0, 0.0};
+    return shape;
+}
+
+ErrorCode sphere_draw_basic(Sphere s, Renderer* r, const Camera* cam) {
+    RenderScene scene = {&s, 1, NULL, 0, NULL, 0};
+    return renderer_draw(r, cam, &scene, false);
+}